@@ -213,6 +213,22 @@ void append_frameworks(Nob_Cmd *cmd)
     nob_cmd_append(cmd, "-framework", "AudioToolbox");
 }
 
+// everything that goes into the plugin (main.c & hotreload.c excluded)
+void append_plug_sources(Nob_Cmd *cmd, Target target)
+{
+    nob_cmd_append(cmd, "./src/plug.c", "./src/pcm.c", "./src/decoder.c",
+                   "./src/readback.c", "./src/encoder.c",
+                   "./src/profile.c", "./src/segment.c",
+                   "./src/softrender.c", "./src/checkpoint.c",
+                   "./src/y4m.c", "./src/spectrum.c", "./src/bands.c",
+                   "./src/bloom.c", "./src/governor.c");
+    if (target == TARGET_WIN64_MINGW || target == TARGET_WIN64_MSVC) {
+        nob_cmd_append(cmd, "./src/ffmpeg_windows.c");
+    } else {
+        nob_cmd_append(cmd, "./src/ffmpeg.c");
+    }
+}
+
 bool load_config_from_file(const char *path, Config *config)
 {
     bool result = true;
@@ -294,7 +310,7 @@ bool build_main(Config config)
                     nob_temp_sprintf("%s.%s.0", version.major, version.minor));
             }
             nob_cmd_append(&cmd, "-o", "./build/libplug.dylib");
-            nob_cmd_append(&cmd, "./src/plug.c", "./src/ffmpeg.c");
+            append_plug_sources(&cmd, config.target);
             nob_cmd_append(
                 &cmd,
                 nob_temp_sprintf("-L./build/raylib/%s",
@@ -310,7 +326,7 @@ bool build_main(Config config)
             nob_cmd_append(&cmd, "-I./raylib/src");
             nob_cmd_append(&cmd, "-DHOTRELOAD");
             nob_cmd_append(&cmd, "-o", "./build/musicalizer");
-            nob_cmd_append(&cmd, "./src/main.c");
+            nob_cmd_append(&cmd, "./src/main.c", "./src/render_cli.c");
             nob_cmd_append(&cmd, "./src/hotreload.c");
 
             // TODO: -install_name @rpath/libraylib.dylib ?
@@ -336,8 +352,8 @@ bool build_main(Config config)
                 nob_cmd_append(&cmd, "-DFEATURE_MICROPHONE");
             nob_cmd_append(&cmd, "-I./raylib/src");
             nob_cmd_append(&cmd, "-o", "./build/musicalizer");
-            nob_cmd_append(&cmd, "./src/plug.c", "./src/ffmpeg.c",
-                           "./src/main.c");
+            append_plug_sources(&cmd, config.target);
+            nob_cmd_append(&cmd, "./src/main.c", "./src/render_cli.c");
             // nob_cmd_append(&cmd, "-L./build/raylib", "-lraylib");
             nob_cmd_append(
                 &cmd,
@@ -367,7 +383,7 @@ bool build_main(Config config)
             nob_cmd_append(&cmd, "-I./raylib/src", "-I./src");
             nob_cmd_append(&cmd, "-fPIC", "-shared", "-o",
                            "./build/libplug.so");
-            nob_cmd_append(&cmd, "./src/plug.c", "./src/ffmpeg.c");
+            append_plug_sources(&cmd, config.target);
             nob_cmd_append(
                 &cmd,
                 nob_temp_sprintf("-L./build/raylib/%s",
@@ -382,7 +398,7 @@ bool build_main(Config config)
             nob_cmd_append(&cmd, "-I./raylib/src");
             nob_cmd_append(&cmd, "-DHOTRELOAD");
             nob_cmd_append(&cmd, "-o", "./build/musicalizer");
-            nob_cmd_append(&cmd, "./src/main.c");
+            nob_cmd_append(&cmd, "./src/main.c", "./src/render_cli.c");
             nob_cmd_append(&cmd, "./src/hotreload.c");
 
             // NOTE: -rpath= is bad syntax (only works with ld in GNU env)
@@ -419,8 +435,8 @@ bool build_main(Config config)
                 nob_cmd_append(&cmd, "-DFEATURE_MICROPHONE");
             nob_cmd_append(&cmd, "-I./raylib/src");
             nob_cmd_append(&cmd, "-o", "./build/musicalizer");
-            nob_cmd_append(&cmd, "./src/plug.c", "./src/ffmpeg.c",
-                           "./src/main.c");
+            append_plug_sources(&cmd, config.target);
+            nob_cmd_append(&cmd, "./src/main.c", "./src/render_cli.c");
             // nob_cmd_append(&cmd, "-L./build/raylib", "-lraylib");
             nob_cmd_append(
                 &cmd,
@@ -459,8 +475,9 @@ bool build_main(Config config)
         nob_cmd_append(&cmd, "-I./raylib/src");
         // nob_cmd_append(&cmd, "-I./build/raylib-windows/include");
         nob_cmd_append(&cmd, "-o", "./build/musicalizer.exe");
-        nob_cmd_append(&cmd, "./src/plug.c", "./src/ffmpeg_windows.c",
-                       "./src/main.c", "./build/musicalizer.res");
+        append_plug_sources(&cmd, config.target);
+        nob_cmd_append(&cmd, "./src/main.c", "./src/render_cli.c",
+                       "./build/musicalizer.res");
         nob_cmd_append(
             &cmd, nob_temp_sprintf("./build/raylib/%s/libraylib.a",
                                    NOB_ARRAY_GET(target_names, config.target)));
@@ -494,8 +511,8 @@ bool build_main(Config config)
             nob_cmd_append(&cmd, "-DFEATURE_MICROPHONE");
         nob_cmd_append(&cmd, "/I", "./raylib/src");
         nob_cmd_append(&cmd, "-o", "/Fobuild\\", "/Febuild\\musicalizer.exe");
-        nob_cmd_append(&cmd, "./src/plug.c", "./src/ffmpeg_windows.c",
-                       "./src/main.c");
+        append_plug_sources(&cmd, config.target);
+        nob_cmd_append(&cmd, "./src/main.c", "./src/render_cli.c");
         // TODO: building resource file is not implemented for TARGET_WIN32_MSVC
         // "./build/musicalizer.res"
         nob_cmd_append(
@@ -0,0 +1,36 @@
+#version 330
+
+// The layers placed by bands.vs: the bars are flat, the smears and the
+// circles glow as in circle.fs.
+
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+uniform int layer;
+uniform float radius;
+uniform float power;
+
+out vec4 finalColor;
+
+void main()
+{
+    if (layer == 0) {
+        finalColor = fragColor;
+        return;
+    }
+
+    float r = radius;
+    vec2 p = fragTexCoord - vec2(0.5);
+    if (length(p) <= 0.5) {
+        float s = length(p) - r;
+        if (s <= 0) {
+            finalColor = 1.5 * fragColor;
+        } else {
+            float t = 1 - s / (0.5 - r);
+            finalColor =
+                mix(vec4(fragColor.xyz, 0), fragColor * 1.5, pow(t, power));
+        }
+    } else {
+        finalColor = vec4(0);
+    }
+}
@@ -0,0 +1,50 @@
+#version 330
+
+// Places the unit quad of an instance (a band) for one layer of the bands, as
+// fft_render() draws them one by one: 0 the bars, 1 the smears (a half of the
+// glow of circle.fs stretched from the smear to the band) and 2 the glowing
+// circles. The band of an instance is gl_InstanceID.
+
+layout(location = 0) in vec2 corner;     // of the unit quad
+layout(location = 1) in vec2 bandValues; // smooth & smear, in 0..1
+layout(location = 2) in vec4 bandColor;
+
+uniform mat4 mvp;
+uniform vec4 boundary; // x, y, width & height
+uniform float count;   // of bands
+uniform int layer;
+uniform float circleScale; // the circles are their cores only below 1
+
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main()
+{
+    float cell = boundary.z / count;
+    float x = boundary.x + (float(gl_InstanceID) + 0.5) * cell;
+    float bottom = boundary.y + boundary.w;
+    float height = boundary.w * 2.0 / 3.0;
+    float t = bandValues.x;
+    float top = bottom - height * t;
+
+    vec2 position;
+    vec2 uv = corner;
+    if (layer == 0) {
+        float thick = cell / 3.0 * sqrt(t);
+        position = vec2(x + (corner.x - 0.5) * thick, mix(top, bottom, corner.y));
+    } else if (layer == 1) {
+        float start = bottom - height * bandValues.y;
+        float radius = cell * 3.0 * sqrt(t);
+        position = vec2(x + (corner.x - 0.5) * radius,
+                        mix(min(start, top), max(start, top), corner.y));
+        // the upper half of the glow when the band goes up
+        uv.y = corner.y * 0.5 + (top >= start ? 0.0 : 0.5);
+    } else {
+        float radius = cell * 6.0 * sqrt(t) * circleScale;
+        position = vec2(x, top) + (corner - 0.5) * 2.0 * radius;
+    }
+
+    fragTexCoord = uv;
+    fragColor = bandColor;
+    gl_Position = mvp * vec4(position, 0.0, 1.0);
+}
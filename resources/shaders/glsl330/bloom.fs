@@ -0,0 +1,32 @@
+#version 330
+
+// One pass of the blur of the bloom (see bloom.h): 9 taps of texture0 along
+// `direction` (a texel of texture0, horizontally or vertically) weighted by a
+// gaussian. With a `threshold`, only what's brighter than it is blurred.
+// NOTE: the blending must be disabled
+
+in vec2 fragTexCoord;
+
+uniform sampler2D texture0;
+uniform vec2 direction;
+uniform float threshold;
+
+out vec4 finalColor;
+
+const float weights[5] =
+    float[](0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
+
+vec3 tap(vec2 uv)
+{
+    return max(texture(texture0, uv).rgb - vec3(threshold), 0.0);
+}
+
+void main()
+{
+    vec3 sum = tap(fragTexCoord) * weights[0];
+    for (int i = 1; i < 5; ++i) {
+        vec2 d = direction * float(i);
+        sum += (tap(fragTexCoord + d) + tap(fragTexCoord - d)) * weights[i];
+    }
+    finalColor = vec4(sum, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 330
+
+// Draws the glyphs of a font whose atlas holds signed distance fields (raylib's
+// FONT_SDF): the alpha of a texel is the distance to the outline, 0.5 on it.
+// The edge is smoothed over a pixel whatever the size of the text.
+
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+uniform sampler2D texture0;
+
+out vec4 finalColor;
+
+void main()
+{
+    float distance = texture(texture0, fragTexCoord).a - 0.5;
+    float pixel = length(vec2(dFdx(distance), dFdy(distance)));
+    float alpha = smoothstep(-pixel, pixel, distance);
+    finalColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
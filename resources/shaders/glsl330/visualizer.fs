@@ -0,0 +1,104 @@
+#version 330
+
+// Draws the whole of fft_render() in a single pass over its boundary, from
+// the bands alone: texture0 is `count` x 1 texels holding the smooth (red)
+// and the smear (green) value of every band. A pixel only blends the bars,
+// then the smears, then the glowing circles of the bands close enough to it,
+// in the order fft_render() draws them.
+// NOTE: the glows are clipped at the boundary
+
+uniform sampler2D texture0;
+uniform vec2 size; // of the boundary
+uniform int count; // of bands
+uniform float circleScale; // the circles are their cores only below 1
+
+in vec2 fragTexCoord;
+
+out vec4 finalColor;
+
+// the widest thing a band draws is its circle, 6 cells on each side
+const int REACH = 6;
+
+// ColorFromHSV() of raylib, at a saturation of 0.75 and a value of 1
+vec3 band_color(int i)
+{
+    float h = float(i) / float(count) * 6.0;
+    vec3 k = mod(vec3(5.0, 3.0, 1.0) + h, 6.0);
+    k = clamp(min(k, 4.0 - k), 0.0, 1.0);
+    return 1.0 - 0.75 * k;
+}
+
+// circle.fs
+vec4 glow(vec2 uv, vec3 color, float r, float power)
+{
+    vec2 p = uv - vec2(0.5);
+    if (length(p) > 0.5)
+        return vec4(0);
+    float s = length(p) - r;
+    if (s <= 0)
+        return 1.5 * vec4(color, 1);
+    float t = 1 - s / (0.5 - r);
+    return mix(vec4(color, 0), vec4(color, 1) * 1.5, pow(t, power));
+}
+
+// the "over" of the blending of raylib, `acc` is premultiplied
+vec4 blend(vec4 acc, vec4 c)
+{
+    c = clamp(c, 0.0, 1.0);
+    return vec4(c.rgb * c.a + acc.rgb * (1 - c.a), c.a + acc.a * (1 - c.a));
+}
+
+void main()
+{
+    vec2 p = fragTexCoord * size;
+    float cell = size.x / float(count);
+    float height = size.y * 2.0 / 3.0;
+    int column = int(p.x / cell);
+    int first = max(column - REACH, 0);
+    int last = min(column + REACH, count - 1);
+
+    vec4 acc = vec4(0);
+
+    // the bars
+    for (int i = first; i <= last; ++i) {
+        float t = texelFetch(texture0, ivec2(i, 0), 0).r;
+        float x = (float(i) + 0.5) * cell;
+        float thick = cell / 3.0 * sqrt(t);
+        if (abs(p.x - x) <= thick / 2.0 && p.y >= size.y - height * t)
+            acc = blend(acc, vec4(band_color(i), 1));
+    }
+
+    // the smears
+    for (int i = first; i <= last; ++i) {
+        vec2 band = texelFetch(texture0, ivec2(i, 0), 0).rg;
+        float x = (float(i) + 0.5) * cell;
+        float start = size.y - height * band.g;
+        float end = size.y - height * band.r;
+        float radius = cell * 3.0 * sqrt(band.r);
+        float top = min(start, end);
+        float bottom = max(start, end);
+        if (radius <= 0.0 || bottom <= top)
+            continue;
+        vec2 uv = vec2((p.x - x) / radius + 0.5, (p.y - top) / (bottom - top));
+        if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0)
+            continue;
+        // the upper half of the glow when the band goes up
+        uv.y = uv.y * 0.5 + (end >= start ? 0.0 : 0.5);
+        acc = blend(acc, glow(uv, band_color(i), 0.3, 3.0));
+    }
+
+    // the circles, with a core of the same size whatever their scale
+    float core = min(0.07 / circleScale, 0.49);
+    for (int i = first; i <= last; ++i) {
+        float t = texelFetch(texture0, ivec2(i, 0), 0).r;
+        float radius = cell * 6.0 * sqrt(t) * circleScale;
+        if (radius <= 0.0)
+            continue;
+        vec2 center = vec2((float(i) + 0.5) * cell, size.y - height * t);
+        vec2 uv = (p - center) / (2.0 * radius) + 0.5;
+        acc = blend(acc, glow(uv, band_color(i), core, 5.0));
+    }
+
+    // blended once more over what's under the boundary
+    finalColor = acc.a > 0.0 ? vec4(acc.rgb / acc.a, acc.a) : vec4(0);
+}
@@ -0,0 +1,50 @@
+#version 330
+
+// Packs the frame in texture0 into planar YUV 4:2:0 (I420): the target is
+// (width / 4) x (height * 3 / 2) RGBA texels, each one holding 4 consecutive
+// bytes of the Y, then the U, then the V plane. The coefficients are the
+// limited range BT.601 ones, as in the default RGBA to yuv420p conversion of
+// ffmpeg.
+// NOTE: texture0 is read top row first and the blending must be disabled
+
+uniform sampler2D texture0;
+uniform vec2 size; // of texture0; the width is a multiple of 4
+
+out vec4 finalColor;
+
+float plane_byte(int i, ivec2 s)
+{
+    int luma_size = s.x * s.y;
+    if (i < luma_size) {
+        vec3 c = texelFetch(texture0, ivec2(i % s.x, i / s.x), 0).rgb;
+        return (16.0 + dot(c, vec3(65.481, 128.553, 24.966))) / 255.0;
+    }
+
+    i -= luma_size;
+    int cw = s.x / 2;
+    int ch = s.y / 2;
+    bool v = i >= cw * ch;
+    if (v) {
+        i -= cw * ch;
+    }
+
+    // the average of the 2x2 block under the chroma sample
+    ivec2 p = ivec2(i % cw, i / cw) * 2;
+    vec3 c = (texelFetch(texture0, p, 0).rgb +
+              texelFetch(texture0, p + ivec2(1, 0), 0).rgb +
+              texelFetch(texture0, p + ivec2(0, 1), 0).rgb +
+              texelFetch(texture0, p + ivec2(1, 1), 0).rgb) / 4.0;
+    if (v) {
+        return (128.0 + dot(c, vec3(112.0, -93.786, -18.214))) / 255.0;
+    }
+    return (128.0 + dot(c, vec3(-37.797, -74.203, 112.0))) / 255.0;
+}
+
+void main()
+{
+    ivec2 s = ivec2(size);
+    ivec2 at = ivec2(gl_FragCoord.xy);
+    int i = (at.y * (s.x / 4) + at.x) * 4;
+    finalColor = vec4(plane_byte(i, s), plane_byte(i + 1, s),
+                      plane_byte(i + 2, s), plane_byte(i + 3, s));
+}
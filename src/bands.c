@@ -0,0 +1,282 @@
+#include "bands.h"
+#include <assert.h>
+#include <rlgl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAYMATH_STATIC_INLINE
+#include "raymath.h"
+
+// NOTE: the GL functions are the ones raylib loaded with glad
+#include "external/glad.h"
+
+// the attributes of bands.vs
+#define BANDS_CORNER_LOCATION 0
+#define BANDS_VALUES_LOCATION 1
+#define BANDS_COLOR_LOCATION  2
+
+// the `layer` of bands.vs & bands.fs
+typedef enum {
+    BANDS_LAYER_BARS,
+    BANDS_LAYER_SMEARS,
+    BANDS_LAYER_CIRCLES,
+} Bands_Layer;
+
+bool bands_load_shader(Bands *bands, const char *vs_path, const char *fs_path)
+{
+    if (bands->shader.id != 0)
+        UnloadShader(bands->shader);
+    bands->shader = LoadShader(vs_path, fs_path);
+    // NOTE: raylib falls back on its default shader when one doesn't compile
+    if (bands->shader.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "BANDS: the bands are drawn one by one");
+        bands->shader = (Shader){0};
+        return false;
+    }
+    bands->mvp_location = GetShaderLocation(bands->shader, "mvp");
+    bands->boundary_location = GetShaderLocation(bands->shader, "boundary");
+    bands->count_location = GetShaderLocation(bands->shader, "count");
+    bands->layer_location = GetShaderLocation(bands->shader, "layer");
+    bands->radius_location = GetShaderLocation(bands->shader, "radius");
+    bands->power_location = GetShaderLocation(bands->shader, "power");
+    bands->circle_scale_location =
+        GetShaderLocation(bands->shader, "circleScale");
+    return true;
+}
+
+float bands_circle_radius(float circle_scale)
+{
+    float radius = 0.07f / circle_scale;
+    return radius < 0.49f ? radius : 0.49f;
+}
+
+const Color *bands_colors(Bands *bands, size_t m)
+{
+    if (bands->color_count != m) {
+        bands->colors = realloc(bands->colors, m * sizeof(*bands->colors));
+        assert(bands->colors != NULL && "Buy more RAM!!");
+        for (size_t i = 0; i < m; ++i) {
+            float hue = (float)i / m;
+            bands->colors[i] = ColorFromHSV(hue * 360, 0.75f, 1.0f);
+        }
+        bands->color_count = m;
+    }
+    return bands->colors;
+}
+
+static void bands_init_buffers(Bands *bands)
+{
+    // a triangle strip facing the camera of raylib (y down)
+    static const float quad[] = {0, 0, 0, 1, 1, 0, 1, 1};
+
+    glGenVertexArrays(1, &bands->vao);
+    glBindVertexArray(bands->vao);
+
+    glGenBuffers(1, &bands->quad);
+    glBindBuffer(GL_ARRAY_BUFFER, bands->quad);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(BANDS_CORNER_LOCATION);
+    glVertexAttribPointer(BANDS_CORNER_LOCATION, 2, GL_FLOAT, GL_FALSE,
+                          2 * sizeof(float), (void *)0);
+
+    // NOTE: the storage of the buffer is allocated by bands_draw()
+    glGenBuffers(1, &bands->instances);
+    glBindBuffer(GL_ARRAY_BUFFER, bands->instances);
+    glEnableVertexAttribArray(BANDS_VALUES_LOCATION);
+    glVertexAttribPointer(BANDS_VALUES_LOCATION, 2, GL_FLOAT, GL_FALSE,
+                          sizeof(Band_Instance),
+                          (void *)offsetof(Band_Instance, smooth));
+    glVertexAttribDivisor(BANDS_VALUES_LOCATION, 1);
+    glEnableVertexAttribArray(BANDS_COLOR_LOCATION);
+    glVertexAttribPointer(BANDS_COLOR_LOCATION, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                          sizeof(Band_Instance),
+                          (void *)offsetof(Band_Instance, color));
+    glVertexAttribDivisor(BANDS_COLOR_LOCATION, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void bands_draw_layer(Bands *bands, Bands_Layer layer, float radius,
+                             float power, size_t m)
+{
+    int l = layer;
+    SetShaderValue(bands->shader, bands->layer_location, &l,
+                   SHADER_UNIFORM_INT);
+    SetShaderValue(bands->shader, bands->radius_location, &radius,
+                   SHADER_UNIFORM_FLOAT);
+    SetShaderValue(bands->shader, bands->power_location, &power,
+                   SHADER_UNIFORM_FLOAT);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m);
+}
+
+bool bands_draw(Bands *bands, Rectangle boundary, const float *smooth,
+                const float *smear, size_t m, float circle_scale)
+{
+    if (bands->shader.id == 0)
+        return false;
+    if (m == 0)
+        return true;
+    if (bands->vao == 0)
+        bands_init_buffers(bands);
+
+    const Color *colors = bands_colors(bands, m);
+    bool grown = m > bands->capacity;
+    if (grown) {
+        bands->items = realloc(bands->items, m * sizeof(*bands->items));
+        assert(bands->items != NULL && "Buy more RAM!!");
+        bands->capacity = m;
+    }
+    for (size_t i = 0; i < m; ++i) {
+        bands->items[i] = (Band_Instance){
+            .smooth = smooth[i],
+            .smear = smear[i],
+            .color = colors[i],
+        };
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, bands->instances);
+    if (grown) {
+        glBufferData(GL_ARRAY_BUFFER, m * sizeof(*bands->items), bands->items,
+                     GL_STREAM_DRAW);
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, m * sizeof(*bands->items),
+                        bands->items);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // NOTE: what's in the batch is drawn first so it stays under the bands
+    rlDrawRenderBatchActive();
+
+    Matrix mvp =
+        MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    SetShaderValueMatrix(bands->shader, bands->mvp_location, mvp);
+    float rect[4] = {boundary.x, boundary.y, boundary.width, boundary.height};
+    SetShaderValue(bands->shader, bands->boundary_location, rect,
+                   SHADER_UNIFORM_VEC4);
+    float count = m;
+    SetShaderValue(bands->shader, bands->count_location, &count,
+                   SHADER_UNIFORM_FLOAT);
+    SetShaderValue(bands->shader, bands->circle_scale_location, &circle_scale,
+                   SHADER_UNIFORM_FLOAT);
+
+    // NOTE: SetShaderValue() binds the program too, but only as a side effect
+    rlEnableShader(bands->shader.id);
+    glBindVertexArray(bands->vao);
+    // the radius & the power of the glow are the ones of circle.fs in the
+    // immediate path of fft_render()
+    bands_draw_layer(bands, BANDS_LAYER_BARS, 0.0f, 0.0f, m);
+    bands_draw_layer(bands, BANDS_LAYER_SMEARS, 0.3f, 3.0f, m);
+    if (circle_scale > 0) {
+        bands_draw_layer(bands, BANDS_LAYER_CIRCLES,
+                         bands_circle_radius(circle_scale), 5.0f, m);
+    }
+    glBindVertexArray(0);
+    rlDisableShader();
+    return true;
+}
+
+void bands_free(Bands *bands)
+{
+    if (bands->shader.id != 0)
+        UnloadShader(bands->shader);
+    if (bands->visualizer.id != 0)
+        UnloadShader(bands->visualizer);
+    if (bands->vao != 0) {
+        glDeleteVertexArrays(1, &bands->vao);
+        glDeleteBuffers(1, &bands->quad);
+        glDeleteBuffers(1, &bands->instances);
+    }
+    if (bands->spectrum != 0)
+        glDeleteTextures(1, &bands->spectrum);
+    free(bands->items);
+    free(bands->colors);
+    free(bands->texels);
+    memset(bands, 0, sizeof(*bands));
+}
+
+bool bands_load_visualizer(Bands *bands, const char *fs_path)
+{
+    if (bands->visualizer.id != 0)
+        UnloadShader(bands->visualizer);
+    bands->visualizer = LoadShader(NULL, fs_path);
+    if (bands->visualizer.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "BANDS: renderer = shader falls back on gpu");
+        bands->visualizer = (Shader){0};
+        return false;
+    }
+    bands->visualizer_size_location =
+        GetShaderLocation(bands->visualizer, "size");
+    bands->visualizer_count_location =
+        GetShaderLocation(bands->visualizer, "count");
+    bands->visualizer_circle_scale_location =
+        GetShaderLocation(bands->visualizer, "circleScale");
+    return true;
+}
+
+// upload the bands into the spectrum texture, which is made again when their
+// count changes
+static void bands_upload(Bands *bands, const float *smooth, const float *smear,
+                         size_t m)
+{
+    bool resized = m != bands->spectrum_width;
+    if (resized) {
+        bands->texels = realloc(bands->texels, 2 * m * sizeof(*bands->texels));
+        assert(bands->texels != NULL && "Buy more RAM!!");
+    }
+    for (size_t i = 0; i < m; ++i) {
+        bands->texels[2 * i] = smooth[i];
+        bands->texels[2 * i + 1] = smear[i];
+    }
+
+    if (bands->spectrum == 0)
+        glGenTextures(1, &bands->spectrum);
+    glBindTexture(GL_TEXTURE_2D, bands->spectrum);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (resized) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, m, 1, 0, GL_RG, GL_FLOAT,
+                     bands->texels);
+        // NOTE: read with texelFetch(), without any filtering
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        bands->spectrum_width = m;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m, 1, GL_RG, GL_FLOAT,
+                        bands->texels);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool bands_draw_visualizer(Bands *bands, Rectangle boundary,
+                           const float *smooth, const float *smear, size_t m,
+                           float circle_scale)
+{
+    if (bands->visualizer.id == 0)
+        return false;
+    if (m == 0)
+        return true;
+
+    // NOTE: EndShaderMode() draws the batch, so the quad reads these bands
+    //       and not the ones of the next call
+    bands_upload(bands, smooth, smear, m);
+
+    float size[2] = {boundary.width, boundary.height};
+    SetShaderValue(bands->visualizer, bands->visualizer_size_location, size,
+                   SHADER_UNIFORM_VEC2);
+    int count = m;
+    SetShaderValue(bands->visualizer, bands->visualizer_count_location,
+                   &count, SHADER_UNIFORM_INT);
+    SetShaderValue(bands->visualizer,
+                   bands->visualizer_circle_scale_location, &circle_scale,
+                   SHADER_UNIFORM_FLOAT);
+
+    // the spectrum is the texture0 of a quad over the boundary (raylib has no
+    // RG32F format, only the size of the texture matters to it)
+    Texture2D texture = {bands->spectrum, m, 1, 1,
+                         PIXELFORMAT_UNCOMPRESSED_R32G32B32A32};
+    BeginShaderMode(bands->visualizer);
+    DrawTexturePro(texture, CLITERAL(Rectangle){0, 0, m, 1}, boundary,
+                   CLITERAL(Vector2){0}, 0, WHITE);
+    EndShaderMode();
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef BANDS_H_
+#define BANDS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+// the values of a band as bands.vs reads them, one per instance
+typedef struct {
+    float smooth;
+    float smear;
+    Color color;
+} Band_Instance;
+
+// NOTE: draws what fft_render() draws with a single draw call per layer (the
+//       bars, the smears and the glowing circles): a unit quad is instanced
+//       once per band and placed by bands.vs from the values of the band,
+//       which are streamed into a buffer of instances every frame
+typedef struct {
+    Shader shader; // bands.vs & bands.fs; not loaded: bands_draw() is a no-op
+    int mvp_location;
+    int boundary_location;
+    int count_location;
+    int layer_location;
+    int radius_location;
+    int power_location;
+    int circle_scale_location;
+
+    // NOTE: the GL objects are made by the first bands_draw()
+    unsigned int vao;
+    unsigned int quad;      // vertex buffer of the unit quad
+    unsigned int instances; // vertex buffer of `capacity` instances
+    size_t capacity;
+    Band_Instance *items;
+
+    // the colour of every band, made again when the count of bands changes
+    Color *colors;
+    size_t color_count;
+
+    // NOTE: the single pass of visualizer.fs (`renderer = shader`) reads the
+    //       bands from a RG32F texture of `spectrum_width` x 1 texels
+    Shader visualizer; // not loaded: bands_draw_visualizer() is a no-op
+    int visualizer_size_location;
+    int visualizer_count_location;
+    int visualizer_circle_scale_location;
+    unsigned int spectrum;
+    size_t spectrum_width;
+    float *texels; // smooth & smear of every band
+} Bands;
+
+// (re)load the shaders; false if they don't compile, the bands must then be
+// drawn one by one
+bool bands_load_shader(Bands *bands, const char *vs_path, const char *fs_path);
+// the colours of `m` bands: a hue per band
+const Color *bands_colors(Bands *bands, size_t m);
+// the radius of the glow of circle.fs around circles drawn at `circle_scale`
+// of their size: their cores stay the same size
+float bands_circle_radius(float circle_scale);
+// draw the `m` bins of `smooth` & `smear` into `boundary` after what's already
+// in the batch of rlgl, the circles at `circle_scale` of their size (1, or
+// BLOOM_CORE_SCALE when the bloom glows, 0: no circles); false if the shaders
+// are not loaded
+bool bands_draw(Bands *bands, Rectangle boundary, const float *smooth,
+                const float *smear, size_t m, float circle_scale);
+
+// (re)load visualizer.fs; false if it doesn't compile
+bool bands_load_visualizer(Bands *bands, const char *fs_path);
+// draw the same as bands_draw() with one fragment shader over `boundary`
+// (through the batch of rlgl); false if visualizer.fs is not loaded
+bool bands_draw_visualizer(Bands *bands, Rectangle boundary,
+                           const float *smooth, const float *smear, size_t m,
+                           float circle_scale);
+// release the shaders, the GL objects and the memory of the bands
+void bands_free(Bands *bands);
+
+#endif // BANDS_H_
@@ -0,0 +1,107 @@
+#include "bloom.h"
+#include <rlgl.h>
+#include <stddef.h>
+
+bool bloom_load_shader(Bloom_Shader *shader, const char *fs_path)
+{
+    if (shader->shader.id != 0)
+        UnloadShader(shader->shader);
+    shader->shader = LoadShader(NULL, fs_path);
+    // NOTE: raylib falls back on its default shader when one doesn't compile
+    if (shader->shader.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "BLOOM: glow = bloom falls back on circles");
+        shader->shader = (Shader){0};
+        return false;
+    }
+    shader->direction_location =
+        GetShaderLocation(shader->shader, "direction");
+    shader->threshold_location =
+        GetShaderLocation(shader->shader, "threshold");
+    return true;
+}
+
+static void bloom_reload_texture(RenderTexture2D *target, int width,
+                                 int height)
+{
+    if (target->texture.width == width && target->texture.height == height)
+        return;
+    UnloadRenderTexture(*target);
+    *target = LoadRenderTexture(width, height);
+    SetTextureFilter(target->texture, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(target->texture, TEXTURE_WRAP_CLAMP);
+}
+
+void bloom_resize(Bloom *bloom, int width, int height)
+{
+    for (int i = 0; i < BLOOM_LEVELS; ++i) {
+        width = width / 2 > 0 ? width / 2 : 1;
+        height = height / 2 > 0 ? height / 2 : 1;
+        bloom_reload_texture(&bloom->passes[i], width, height);
+        bloom_reload_texture(&bloom->levels[i], width, height);
+    }
+}
+
+void bloom_free(Bloom *bloom)
+{
+    for (int i = 0; i < BLOOM_LEVELS; ++i) {
+        UnloadRenderTexture(bloom->passes[i]);
+        UnloadRenderTexture(bloom->levels[i]);
+        bloom->passes[i] = (RenderTexture2D){0};
+        bloom->levels[i] = (RenderTexture2D){0};
+    }
+}
+
+// one pass of bloom.fs from `source` onto the whole of `target`, along
+// `direction` (in texels of `source`)
+static void bloom_pass(const Bloom_Shader *shader, Texture2D source,
+                       RenderTexture2D target, Vector2 direction,
+                       float threshold)
+{
+    Vector2 step = {direction.x / source.width, direction.y / source.height};
+    SetShaderValue(shader->shader, shader->direction_location, &step,
+                   SHADER_UNIFORM_VEC2);
+    SetShaderValue(shader->shader, shader->threshold_location, &threshold,
+                   SHADER_UNIFORM_FLOAT);
+
+    BeginTextureMode(target);
+    rlDisableColorBlend();
+    BeginShaderMode(shader->shader);
+    // NOTE: the negative height keeps the rows where they are in the memory
+    DrawTexturePro(source,
+                   CLITERAL(Rectangle){0, 0, source.width, -source.height},
+                   CLITERAL(Rectangle){0, 0, target.texture.width,
+                                       target.texture.height},
+                   CLITERAL(Vector2){0}, 0, WHITE);
+    EndShaderMode();
+    rlEnableColorBlend();
+    EndTextureMode();
+}
+
+void bloom_blur(Bloom *bloom, const Bloom_Shader *shader,
+                RenderTexture2D screen)
+{
+    // the first level is read from the frame at half its size
+    SetTextureFilter(screen.texture, TEXTURE_FILTER_BILINEAR);
+    Texture2D source = screen.texture;
+    for (int i = 0; i < BLOOM_LEVELS; ++i) {
+        float threshold = i == 0 ? BLOOM_THRESHOLD : 0.0f;
+        bloom_pass(shader, source, bloom->passes[i], CLITERAL(Vector2){1, 0},
+                   threshold);
+        bloom_pass(shader, bloom->passes[i].texture, bloom->levels[i],
+                   CLITERAL(Vector2){0, 1}, 0.0f);
+        source = bloom->levels[i].texture;
+    }
+}
+
+void bloom_composite(const Bloom *bloom, Rectangle dest)
+{
+    BeginBlendMode(BLEND_ADDITIVE);
+    Color tint = ColorAlpha(WHITE, BLOOM_INTENSITY);
+    for (int i = 0; i < BLOOM_LEVELS; ++i) {
+        Texture2D level = bloom->levels[i].texture;
+        DrawTexturePro(level,
+                       CLITERAL(Rectangle){0, 0, level.width, level.height},
+                       dest, CLITERAL(Vector2){0}, 0, tint);
+    }
+    EndBlendMode();
+}
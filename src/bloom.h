@@ -0,0 +1,43 @@
+#ifndef BLOOM_H_
+#define BLOOM_H_
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+#define BLOOM_LEVELS     3
+// the circles are drawn this much smaller when the bloom makes their glow
+#define BLOOM_CORE_SCALE 0.25f
+// NOTE: the background (0x151515) stays under the threshold
+#define BLOOM_THRESHOLD  0.1f
+#define BLOOM_INTENSITY  0.8f
+
+typedef struct {
+    Shader shader; // bloom.fs; not loaded: no bloom
+    int direction_location;
+    int threshold_location;
+} Bloom_Shader;
+
+// NOTE: the glow of a whole frame at once (`glow = bloom`): what's brighter
+//       than the background is blurred at 1/2, 1/4 & 1/8 of the size of the
+//       frame by two passes (horizontal, then vertical) per level and the
+//       levels are added back onto the frame, so the glow costs the same
+//       whatever the count of bands and however much the circles overlap
+typedef struct {
+    RenderTexture2D levels[BLOOM_LEVELS];
+    RenderTexture2D passes[BLOOM_LEVELS]; // the horizontal pass of a level
+} Bloom;
+
+// (re)load bloom.fs; false if it doesn't compile
+bool bloom_load_shader(Bloom_Shader *shader, const char *fs_path);
+// (re)allocate the levels for a frame of `width` x `height`
+void bloom_resize(Bloom *bloom, int width, int height);
+void bloom_free(Bloom *bloom);
+// blur the bright parts of `screen` into the levels
+void bloom_blur(Bloom *bloom, const Bloom_Shader *shader,
+                RenderTexture2D screen);
+// add the levels to `dest` of the target being drawn, which must be drawn top
+// row first like `screen` was (the levels keep the rows of `screen` in place)
+void bloom_composite(const Bloom *bloom, Rectangle dest);
+
+#endif // BLOOM_H_
@@ -0,0 +1,135 @@
+#include "checkpoint.h"
+#include "raylib.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif // _WIN32
+
+#define CHECKPOINT_MAGIC   "MZCP"
+#define CHECKPOINT_VERSION 1
+
+// NOTE: the file is read by the build that wrote it, the values are stored
+//       in the byte order and the sizes of the machine
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t key_size;
+    uint64_t chunk_count;
+} Checkpoint_Header;
+
+static bool checkpoint_write(FILE *f, const char *key, const Checkpoint *cp,
+                             const Checkpoint_Chunk *chunks, size_t count)
+{
+    Checkpoint_Header header = {
+        .magic = CHECKPOINT_MAGIC,
+        .version = CHECKPOINT_VERSION,
+        .key_size = strlen(key),
+        .chunk_count = count,
+    };
+    if (fwrite(&header, sizeof(header), 1, f) != 1 ||
+        fwrite(key, 1, header.key_size, f) != header.key_size ||
+        fwrite(cp, sizeof(*cp), 1, f) != 1)
+        return false;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t size = chunks[i].size;
+        if (fwrite(&size, sizeof(size), 1, f) != 1 ||
+            fwrite(chunks[i].data, 1, chunks[i].size, f) != chunks[i].size)
+            return false;
+    }
+    if (fflush(f) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif // _WIN32
+}
+
+bool checkpoint_save(const char *path, const char *key, const Checkpoint *cp,
+                     const Checkpoint_Chunk *chunks, size_t count)
+{
+    const char *temp_path = TextFormat("%s.tmp", path);
+    FILE *f = fopen(temp_path, "wb");
+    if (f == NULL) {
+        TraceLog(LOG_ERROR, "CHECKPOINT: could not open %s: %s", temp_path,
+                 strerror(errno));
+        return false;
+    }
+    bool ok = checkpoint_write(f, key, cp, chunks, count);
+    if (fclose(f) != 0)
+        ok = false;
+    if (!ok) {
+        TraceLog(LOG_ERROR, "CHECKPOINT: could not write %s: %s", temp_path,
+                 strerror(errno));
+        remove(temp_path);
+        return false;
+    }
+
+#ifdef _WIN32
+    // NOTE: rename() doesn't replace an existing file on Windows
+    remove(path);
+#endif // _WIN32
+    if (rename(temp_path, path) != 0) {
+        TraceLog(LOG_ERROR, "CHECKPOINT: could not rename %s to %s: %s",
+                 temp_path, path, strerror(errno));
+        remove(temp_path);
+        return false;
+    }
+    return true;
+}
+
+bool checkpoint_load(const char *path, const char *key, Checkpoint *cp,
+                     const Checkpoint_Chunk *chunks, size_t count)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return false;
+
+    bool ok = false;
+    char *file_key = NULL;
+    Checkpoint_Header header;
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CHECKPOINT_VERSION || header.chunk_count != count ||
+        header.key_size != strlen(key))
+        goto defer;
+
+    file_key = malloc(header.key_size);
+    assert(file_key != NULL && "Buy more RAM!!");
+    if (fread(file_key, 1, header.key_size, f) != header.key_size ||
+        memcmp(file_key, key, header.key_size) != 0)
+        goto defer;
+
+    if (fread(cp, sizeof(*cp), 1, f) != 1)
+        goto defer;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t size;
+        if (fread(&size, sizeof(size), 1, f) != 1 || size != chunks[i].size ||
+            fread(chunks[i].data, 1, chunks[i].size, f) != chunks[i].size)
+            goto defer;
+    }
+    ok = true;
+
+defer:
+    if (!ok)
+        TraceLog(LOG_WARNING, "CHECKPOINT: %s is not a checkpoint of this "
+                              "render, starting over",
+                 path);
+    free(file_key);
+    fclose(f);
+    return ok;
+}
+
+void checkpoint_remove(const char *path)
+{
+    remove(path);
+    remove(TextFormat("%s.tmp", path));
+}
@@ -0,0 +1,35 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// a piece of the state of a render, saved as is
+typedef struct {
+    void *data;
+    size_t size;
+} Checkpoint_Chunk;
+
+// NOTE: a checkpoint is where an interrupted render resumes from: the number
+//       of closed parts of the video written so far, the frame that follows
+//       them and the state of the analysis at that frame (the chunks, opaque
+//       here); the `key` describes the render (track, profiles, frames...) so
+//       the checkpoint of another one is never resumed
+typedef struct {
+    size_t parts;
+    size_t frame;
+    size_t wave_cursor;
+    double seconds; // spent rendering up to `frame`
+} Checkpoint;
+
+// NOTE: the checkpoint goes into a temporary file renamed over `path` once
+//       it's on disk so a crash while saving keeps the previous one
+bool checkpoint_save(const char *path, const char *key, const Checkpoint *cp,
+                     const Checkpoint_Chunk *chunks, size_t count);
+// false if there's no checkpoint of `key` at `path`; the chunks may be
+// clobbered even then
+bool checkpoint_load(const char *path, const char *key, Checkpoint *cp,
+                     const Checkpoint_Chunk *chunks, size_t count);
+void checkpoint_remove(const char *path);
+
+#endif // CHECKPOINT_H_
@@ -0,0 +1,19 @@
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <time.h>
+
+// seconds since an arbitrary point, for measuring how long things take
+// NOTE: not GetTime() which needs a window
+static inline double clock_now()
+{
+    struct timespec ts;
+#ifdef _WIN32
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif // _WIN32
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#endif // CLOCK_H_
@@ -0,0 +1,427 @@
+#include "decoder.h"
+#include "raylib.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "pcm.h"
+
+// NOTE: raylib compiles its own copy of dr_mp3 (and maybe dr_flac); ours stays
+//       private to this file so the symbols never clash
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#define DRFLAC_API static
+#define DR_FLAC_IMPLEMENTATION
+#define DR_FLAC_NO_STDIO
+#define DR_FLAC_NO_OGG
+#include "external/dr_flac.h"
+#define DRMP3_API static
+#define DR_MP3_IMPLEMENTATION
+#define DR_MP3_NO_STDIO
+#include "external/dr_mp3.h"
+#pragma GCC diagnostic pop
+
+#define DECODER_CHUNK_FRAMES (1 << 16)
+#define DECODER_NO_CHUNK     SIZE_MAX
+
+typedef enum {
+    DECODER_FLAC,
+    DECODER_MP3,
+} Decoder_Kind;
+
+typedef struct {
+    size_t chunk; // DECODER_NO_CHUNK until a worker fills the slot
+    float *samples;
+} Decoder_Slot;
+
+typedef struct {
+    Decoder_Kind kind;
+    void *data;
+    size_t size;
+    Decoder_Info info;
+    size_t chunk_count;
+    drmp3_seek_point *seek_points;
+    drmp3_uint32 seek_point_count;
+
+    Decoder_Slot *slots;
+    size_t slot_count;
+#ifdef _WIN32
+    // NOTE: there's no pool, decoder_read() decodes the chunks itself into
+    //       its single slot
+    void *worker; // Decoder_Worker
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t ready; // a slot has been filled
+    pthread_cond_t moved; // the reader moved on (or seeked)
+    pthread_t *threads;
+    size_t workers;
+    size_t failed;      // workers that could not open the stream
+    size_t next_chunk;  // next chunk to hand out to a worker
+    size_t first_chunk; // oldest chunk the reader may still ask for
+    size_t generation;  // bumped on seek so stale chunks are dropped
+    bool stop;
+#endif // _WIN32
+} Decoder_Pool;
+
+typedef struct {
+    drflac *flac;
+    drmp3 mp3;
+    float *interleaved;
+    float *samples;
+} Decoder_Worker;
+
+static bool worker_open(Decoder_Pool *pool, Decoder_Worker *w)
+{
+    switch (pool->kind) {
+    case DECODER_FLAC:
+        w->flac = drflac_open_memory(pool->data, pool->size, NULL);
+        return w->flac != NULL;
+    case DECODER_MP3:
+        if (!drmp3_init_memory(&w->mp3, pool->data, pool->size, NULL))
+            return false;
+        if (pool->seek_points != NULL)
+            drmp3_bind_seek_table(&w->mp3, pool->seek_point_count,
+                                  pool->seek_points);
+        return true;
+    }
+    return false;
+}
+
+static void worker_close(Decoder_Pool *pool, Decoder_Worker *w)
+{
+    switch (pool->kind) {
+    case DECODER_FLAC:
+        drflac_close(w->flac);
+        break;
+    case DECODER_MP3:
+        drmp3_uninit(&w->mp3);
+        break;
+    }
+}
+
+static void worker_decode(Decoder_Pool *pool, Decoder_Worker *w, size_t chunk)
+{
+    size_t first = chunk * DECODER_CHUNK_FRAMES;
+    size_t count = pool->info.frame_count - first;
+    if (count > DECODER_CHUNK_FRAMES)
+        count = DECODER_CHUNK_FRAMES;
+
+    size_t decoded = 0;
+    switch (pool->kind) {
+    case DECODER_FLAC:
+        if (drflac_seek_to_pcm_frame(w->flac, first))
+            decoded = drflac_read_pcm_frames_f32(w->flac, count, w->interleaved);
+        break;
+    case DECODER_MP3:
+        if (drmp3_seek_to_pcm_frame(&w->mp3, first))
+            decoded = drmp3_read_pcm_frames_f32(&w->mp3, count, w->interleaved);
+        break;
+    }
+
+    for (size_t i = 0; i < decoded; ++i)
+        w->samples[i] = w->interleaved[i * pool->info.channels + 0];
+    for (size_t i = decoded; i < DECODER_CHUNK_FRAMES; ++i)
+        w->samples[i] = 0.0f;
+}
+
+#ifndef _WIN32
+static void *worker_thread(void *arg)
+{
+    Decoder_Pool *pool = arg;
+    Decoder_Worker w = {0};
+
+    if (!worker_open(pool, &w)) {
+        TraceLog(LOG_ERROR, "DECODER: worker could not open the stream");
+        // NOTE: the other workers take its chunks; without any left, the
+        //       reader must not wait for them
+        pthread_mutex_lock(&pool->mutex);
+        pool->failed += 1;
+        pthread_cond_broadcast(&pool->ready);
+        pthread_mutex_unlock(&pool->mutex);
+        return NULL;
+    }
+    w.interleaved = malloc(sizeof(float) * DECODER_CHUNK_FRAMES *
+                           pool->info.channels);
+    w.samples = malloc(sizeof(float) * DECODER_CHUNK_FRAMES);
+    assert(w.interleaved != NULL && w.samples != NULL && "Buy more RAM!!");
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (!pool->stop &&
+               (pool->next_chunk >= pool->chunk_count ||
+                pool->next_chunk >= pool->first_chunk + pool->slot_count)) {
+            pthread_cond_wait(&pool->moved, &pool->mutex);
+        }
+        if (pool->stop)
+            break;
+
+        size_t chunk = pool->next_chunk++;
+        size_t generation = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        worker_decode(pool, &w, chunk);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (generation == pool->generation) {
+            Decoder_Slot *slot = &pool->slots[chunk % pool->slot_count];
+            float *samples = slot->samples;
+            slot->samples = w.samples;
+            slot->chunk = chunk;
+            w.samples = samples;
+            pthread_cond_broadcast(&pool->ready);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    free(w.interleaved);
+    free(w.samples);
+    worker_close(pool, &w);
+    return NULL;
+}
+
+// NOTE: must be called with the mutex locked
+static void pool_seek(Decoder_Pool *pool, size_t chunk)
+{
+    pool->generation += 1;
+    pool->first_chunk = chunk;
+    pool->next_chunk = chunk;
+    for (size_t i = 0; i < pool->slot_count; ++i)
+        pool->slots[i].chunk = DECODER_NO_CHUNK;
+    pthread_cond_broadcast(&pool->moved);
+}
+#endif // _WIN32
+
+static bool pool_probe(Decoder_Pool *pool)
+{
+    switch (pool->kind) {
+    case DECODER_FLAC: {
+        drflac *flac = drflac_open_memory(pool->data, pool->size, NULL);
+        if (flac == NULL)
+            return false;
+        pool->info.frame_count = flac->totalPCMFrameCount;
+        pool->info.sample_rate = flac->sampleRate;
+        pool->info.channels = flac->channels;
+        drflac_close(flac);
+    } break;
+    case DECODER_MP3: {
+        drmp3 mp3;
+        if (!drmp3_init_memory(&mp3, pool->data, pool->size, NULL))
+            return false;
+        pool->info.frame_count = drmp3_get_pcm_frame_count(&mp3);
+        pool->info.sample_rate = mp3.sampleRate;
+        pool->info.channels = mp3.channels;
+        // one seek point per chunk so every worker jumps straight to its own
+        drmp3_uint32 count =
+            (pool->info.frame_count + DECODER_CHUNK_FRAMES - 1) /
+            DECODER_CHUNK_FRAMES;
+        if (count > 0) {
+            pool->seek_points = malloc(sizeof(drmp3_seek_point) * count);
+            assert(pool->seek_points != NULL && "Buy more RAM!!");
+            if (drmp3_calculate_seek_points(&mp3, &count, pool->seek_points)) {
+                pool->seek_point_count = count;
+            } else {
+                free(pool->seek_points);
+                pool->seek_points = NULL;
+            }
+        }
+        drmp3_uninit(&mp3);
+    } break;
+    }
+    // NOTE: a streamed FLAC may not tell its length up front
+    return pool->info.frame_count > 0 && pool->info.channels > 0;
+}
+
+Decoder *decoder_start(const char *file_path, size_t workers,
+                       Decoder_Info *info)
+{
+    Decoder_Kind kind;
+    if (IsFileExtension(file_path, ".flac")) {
+        kind = DECODER_FLAC;
+    } else if (IsFileExtension(file_path, ".mp3")) {
+        kind = DECODER_MP3;
+    } else {
+        return NULL;
+    }
+
+#ifdef _WIN32
+    workers = 1;
+#else
+    if (workers == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 0 ? (size_t)cpus : 1;
+    }
+#endif // _WIN32
+
+    Decoder_Pool *pool = malloc(sizeof(Decoder_Pool));
+    assert(pool != NULL && "Buy more RAM!!");
+    memset(pool, 0, sizeof(*pool));
+    pool->kind = kind;
+
+    pool->data = pcm_map_file(file_path, &pool->size);
+    if (pool->data == NULL) {
+        free(pool);
+        return NULL;
+    }
+
+    if (!pool_probe(pool)) {
+        TraceLog(LOG_WARNING, "DECODER: could not probe %s", file_path);
+        pcm_unmap_file(pool->data, pool->size);
+        free(pool->seek_points);
+        free(pool);
+        return NULL;
+    }
+
+    pool->chunk_count = (pool->info.frame_count + DECODER_CHUNK_FRAMES - 1) /
+                        DECODER_CHUNK_FRAMES;
+    if (workers > pool->chunk_count)
+        workers = pool->chunk_count;
+#ifdef _WIN32
+    pool->slot_count = 1;
+#else
+    // twice as many slots as workers so the pool keeps going while the
+    // reader goes through a chunk
+    pool->slot_count = workers * 2;
+#endif // _WIN32
+    pool->slots = malloc(sizeof(Decoder_Slot) * pool->slot_count);
+    assert(pool->slots != NULL && "Buy more RAM!!");
+    for (size_t i = 0; i < pool->slot_count; ++i) {
+        pool->slots[i].chunk = DECODER_NO_CHUNK;
+        pool->slots[i].samples = malloc(sizeof(float) * DECODER_CHUNK_FRAMES);
+        assert(pool->slots[i].samples != NULL && "Buy more RAM!!");
+    }
+
+#ifdef _WIN32
+    Decoder_Worker *w = malloc(sizeof(Decoder_Worker));
+    assert(w != NULL && "Buy more RAM!!");
+    memset(w, 0, sizeof(*w));
+    pool->worker = w;
+    if (!worker_open(pool, w)) {
+        TraceLog(LOG_ERROR, "DECODER: could not open the stream of %s",
+                 file_path);
+        free(w);
+        pool->worker = NULL;
+        decoder_stop(pool);
+        return NULL;
+    }
+    w->interleaved = malloc(sizeof(float) * DECODER_CHUNK_FRAMES *
+                            pool->info.channels);
+    assert(w->interleaved != NULL && "Buy more RAM!!");
+    TraceLog(LOG_INFO, "DECODER: decoding %s (%zu chunks)", file_path,
+             pool->chunk_count);
+#else
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->ready, NULL);
+    pthread_cond_init(&pool->moved, NULL);
+
+    pool->threads = malloc(sizeof(pthread_t) * workers);
+    assert(pool->threads != NULL && "Buy more RAM!!");
+    for (size_t i = 0; i < workers; ++i) {
+        if (pthread_create(&pool->threads[i], NULL, worker_thread, pool) != 0)
+            break;
+        pool->workers += 1;
+    }
+    if (pool->workers == 0) {
+        TraceLog(LOG_ERROR, "DECODER: could not start any worker");
+        decoder_stop(pool);
+        return NULL;
+    }
+
+    TraceLog(LOG_INFO, "DECODER: decoding %s with %zu workers (%zu chunks)",
+             file_path, pool->workers, pool->chunk_count);
+#endif // _WIN32
+    *info = pool->info;
+    return pool;
+}
+
+void decoder_read(Decoder *decoder, size_t frame, float *out, size_t count)
+{
+    Decoder_Pool *pool = decoder;
+
+    while (count > 0) {
+        size_t chunk = frame / DECODER_CHUNK_FRAMES;
+        size_t offset = frame % DECODER_CHUNK_FRAMES;
+        size_t n = DECODER_CHUNK_FRAMES - offset;
+        if (n > count)
+            n = count;
+
+        if (chunk >= pool->chunk_count) {
+            memset(out, 0, sizeof(float) * count);
+            return;
+        }
+
+#ifdef _WIN32
+        Decoder_Slot *slot = &pool->slots[0];
+        if (slot->chunk != chunk) {
+            Decoder_Worker *w = pool->worker;
+            w->samples = slot->samples;
+            worker_decode(pool, w, chunk);
+            slot->chunk = chunk;
+        }
+#else
+        pthread_mutex_lock(&pool->mutex);
+        if (chunk < pool->first_chunk ||
+            chunk >= pool->first_chunk + pool->slot_count) {
+            pool_seek(pool, chunk);
+        } else if (chunk > pool->first_chunk) {
+            pool->first_chunk = chunk;
+            pthread_cond_broadcast(&pool->moved);
+        }
+        Decoder_Slot *slot = &pool->slots[chunk % pool->slot_count];
+        while (slot->chunk != chunk && pool->failed < pool->workers)
+            pthread_cond_wait(&pool->ready, &pool->mutex);
+        bool failed = slot->chunk != chunk;
+        pthread_mutex_unlock(&pool->mutex);
+        if (failed) {
+            memset(out, 0, sizeof(float) * count);
+            return;
+        }
+#endif // _WIN32
+
+        // NOTE: the slot can't be recycled while `chunk` is the first one
+        memcpy(out, slot->samples + offset, sizeof(float) * n);
+
+        out += n;
+        frame += n;
+        count -= n;
+    }
+}
+
+void decoder_stop(Decoder *decoder)
+{
+    Decoder_Pool *pool = decoder;
+
+#ifdef _WIN32
+    Decoder_Worker *w = pool->worker;
+    if (w != NULL) {
+        worker_close(pool, w);
+        free(w->interleaved);
+        free(w);
+    }
+#else
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->moved);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (size_t i = 0; i < pool->workers; ++i)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->moved);
+    pthread_cond_destroy(&pool->ready);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+#endif // _WIN32
+
+    for (size_t i = 0; i < pool->slot_count; ++i)
+        free(pool->slots[i].samples);
+    free(pool->slots);
+    free(pool->seek_points);
+    pcm_unmap_file(pool->data, pool->size);
+    free(pool);
+}
@@ -0,0 +1,27 @@
+#ifndef DECODER_H_
+#define DECODER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef void Decoder;
+
+typedef struct {
+    size_t frame_count;
+    unsigned int sample_rate;
+    unsigned int channels;
+} Decoder_Info;
+
+// FLAC and MP3 files are split into chunks of frames that are decoded
+// concurrently by a pool of `workers` threads (0 means one per CPU); the
+// chunks are handed back in order by decoder_read()
+// NOTE: on Windows there's no pool, decoder_read() decodes the chunks itself
+Decoder *decoder_start(const char *file_path, size_t workers,
+                       Decoder_Info *info);
+// read `count` frames of the left channel starting at `frame` into `out`;
+// the frames past the end are zeroed
+// NOTE: reading backward or far ahead restarts the pool at `frame`
+void decoder_read(Decoder *decoder, size_t frame, float *out, size_t count);
+void decoder_stop(Decoder *decoder);
+
+#endif // DECODER_H_
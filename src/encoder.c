@@ -0,0 +1,300 @@
+#include "encoder.h"
+#include "clock.h"
+#include "raylib.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif // _WIN32
+
+typedef struct {
+    FFMPEG *ffmpeg;
+    // NOTE: the frames written into a Y4M file go straight into its mapping,
+    //       there's no queue nor writer then
+    Y4M_Writer *y4m;
+    size_t frame_size;
+    // NOTE: the frames are a ring; [written, submitted) is the queue and the
+    //       rest is the pool of free buffers
+    void **frames;
+    size_t *repeats; // the extra times each queued frame is written
+    size_t capacity;
+    size_t submitted;
+    size_t written;
+    bool stopping;
+    bool failed;
+    Encoder_Stats stats;
+    FFMPEG_Progress progress; // only touched by the writer
+#ifndef _WIN32
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t filled;  // a frame has been submitted (or stopping)
+    pthread_cond_t drained; // a frame has been written
+#endif // _WIN32
+} Encoder_Queue;
+
+#ifndef _WIN32
+static void *encoder_writer(void *arg)
+{
+    Encoder_Queue *q = arg;
+
+    pthread_mutex_lock(&q->mutex);
+    for (;;) {
+        while (q->written == q->submitted && !q->stopping)
+            pthread_cond_wait(&q->filled, &q->mutex);
+        if (q->written == q->submitted)
+            break;
+
+        size_t slot = q->written % q->capacity;
+        void *frame = q->frames[slot];
+        bool failed = q->failed;
+        pthread_mutex_unlock(&q->mutex);
+
+        // the frames left after a failure are dropped
+        double start = clock_now();
+        bool ok = failed || ffmpeg_send_frame(q->ffmpeg, frame, q->frame_size);
+        double write_time = clock_now() - start;
+        FFMPEG_Progress progress = q->progress;
+        bool progressed = ffmpeg_progress(q->ffmpeg, &progress);
+
+        pthread_mutex_lock(&q->mutex);
+        if (!ok)
+            q->failed = true;
+        else if (!failed)
+            q->stats.frames += 1;
+        q->stats.write_time += write_time;
+        if (progressed)
+            q->stats.ffmpeg = q->progress = progress;
+        // NOTE: encoder_repeat() may add to the count while the frame is
+        //       being written
+        if (q->repeats[slot] > 0 && !q->failed) {
+            q->repeats[slot] -= 1;
+            continue;
+        }
+        q->repeats[slot] = 0;
+        q->written += 1;
+        pthread_cond_signal(&q->drained);
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    return NULL;
+}
+#endif // _WIN32
+
+static void encoder_free(Encoder_Queue *q)
+{
+    for (size_t i = 0; i < q->capacity; ++i)
+        free(q->frames[i]);
+    free(q->frames);
+    free(q->repeats);
+    free(q);
+}
+
+Encoder *encoder_start(FFMPEG *ffmpeg, size_t frame_size, size_t queue)
+{
+    assert(ffmpeg != NULL && queue > 0);
+
+    Encoder_Queue *q = malloc(sizeof(*q));
+    assert(q != NULL && "Buy more RAM lol!!");
+    memset(q, 0, sizeof(*q));
+    q->ffmpeg = ffmpeg;
+    q->frame_size = frame_size;
+#ifdef _WIN32
+    // there is no writer to queue the frames for
+    queue = 1;
+#endif // _WIN32
+    q->capacity = queue;
+    q->frames = malloc(queue * sizeof(*q->frames));
+    assert(q->frames != NULL && "Buy more RAM lol!!");
+    for (size_t i = 0; i < queue; ++i) {
+        q->frames[i] = malloc(frame_size);
+        assert(q->frames[i] != NULL && "Buy more RAM lol!!");
+    }
+    q->repeats = calloc(queue, sizeof(*q->repeats));
+    assert(q->repeats != NULL && "Buy more RAM lol!!");
+
+#ifndef _WIN32
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->filled, NULL);
+    pthread_cond_init(&q->drained, NULL);
+    int err = pthread_create(&q->thread, NULL, encoder_writer, q);
+    if (err != 0) {
+        TraceLog(LOG_ERROR, "ENCODER: could not start the writer thread: %s",
+                 strerror(err));
+        pthread_cond_destroy(&q->drained);
+        pthread_cond_destroy(&q->filled);
+        pthread_mutex_destroy(&q->mutex);
+        encoder_free(q);
+        ffmpeg_end_rendering(ffmpeg);
+        return NULL;
+    }
+#endif // _WIN32
+
+    return q;
+}
+
+Encoder *encoder_start_y4m(Y4M_Writer *y4m)
+{
+    assert(y4m != NULL);
+
+    Encoder_Queue *q = malloc(sizeof(*q));
+    assert(q != NULL && "Buy more RAM lol!!");
+    memset(q, 0, sizeof(*q));
+    q->y4m = y4m;
+    return q;
+}
+
+void *encoder_acquire(Encoder *encoder)
+{
+    Encoder_Queue *q = encoder;
+    void *frame = NULL;
+
+    if (q->y4m != NULL) {
+        if (!q->failed)
+            frame = y4m_frame(q->y4m);
+        q->failed = frame == NULL;
+        return frame;
+    }
+
+#ifdef _WIN32
+    if (!q->failed)
+        frame = q->frames[0];
+#else
+    pthread_mutex_lock(&q->mutex);
+    if (q->submitted - q->written == q->capacity && !q->failed) {
+        double start = clock_now();
+        while (q->submitted - q->written == q->capacity && !q->failed)
+            pthread_cond_wait(&q->drained, &q->mutex);
+        q->stats.stalls += 1;
+        q->stats.wait_time += clock_now() - start;
+    }
+    if (!q->failed)
+        frame = q->frames[q->submitted % q->capacity];
+    pthread_mutex_unlock(&q->mutex);
+#endif // _WIN32
+
+    return frame;
+}
+
+void encoder_submit(Encoder *encoder)
+{
+    Encoder_Queue *q = encoder;
+
+    if (q->y4m != NULL) {
+        q->stats.frames += 1;
+        return;
+    }
+
+#ifdef _WIN32
+    if (!ffmpeg_send_frame(q->ffmpeg, q->frames[0], q->frame_size))
+        q->failed = true;
+    else
+        q->stats.frames += 1;
+    ffmpeg_progress(q->ffmpeg, &q->stats.ffmpeg);
+#else
+    pthread_mutex_lock(&q->mutex);
+    assert(q->submitted - q->written < q->capacity);
+    q->submitted += 1;
+    pthread_cond_signal(&q->filled);
+    pthread_mutex_unlock(&q->mutex);
+#endif // _WIN32
+}
+
+void encoder_repeat(Encoder *encoder)
+{
+    Encoder_Queue *q = encoder;
+
+    if (q->y4m != NULL) {
+        if (q->failed)
+            return;
+        if (y4m_repeat(q->y4m)) {
+            q->stats.frames += 1;
+            q->stats.repeats += 1;
+        } else {
+            q->failed = true;
+        }
+        return;
+    }
+
+#ifdef _WIN32
+    // the only buffer still holds the last frame
+    if (q->failed)
+        return;
+    if (ffmpeg_send_frame(q->ffmpeg, q->frames[0], q->frame_size)) {
+        q->stats.frames += 1;
+        q->stats.repeats += 1;
+    } else {
+        q->failed = true;
+    }
+#else
+    pthread_mutex_lock(&q->mutex);
+    assert(q->submitted > 0);
+    size_t last = (q->submitted - 1) % q->capacity;
+    if (q->written < q->submitted) {
+        // still queued, it's written once more
+        q->repeats[last] += 1;
+    } else {
+        // NOTE: the queue is empty and the writer is done with the last frame
+        //       so its buffer is swapped into the next slot and queued again
+        size_t next = q->submitted % q->capacity;
+        void *frame = q->frames[last];
+        q->frames[last] = q->frames[next];
+        q->frames[next] = frame;
+        q->repeats[next] = 0;
+        q->submitted += 1;
+        pthread_cond_signal(&q->filled);
+    }
+    q->stats.repeats += 1;
+    pthread_mutex_unlock(&q->mutex);
+#endif // _WIN32
+}
+
+void encoder_stats(Encoder *encoder, Encoder_Stats *stats)
+{
+    Encoder_Queue *q = encoder;
+    if (q->y4m != NULL) {
+        *stats = q->stats;
+        return;
+    }
+#ifndef _WIN32
+    pthread_mutex_lock(&q->mutex);
+    *stats = q->stats;
+    pthread_mutex_unlock(&q->mutex);
+#else
+    *stats = q->stats;
+#endif // _WIN32
+}
+
+bool encoder_stop(Encoder *encoder, Encoder_Stats *stats)
+{
+    Encoder_Queue *q = encoder;
+
+    if (q->y4m != NULL) {
+        bool ok = y4m_end(q->y4m) && !q->failed;
+        if (stats != NULL)
+            *stats = q->stats;
+        free(q);
+        return ok;
+    }
+
+#ifndef _WIN32
+    pthread_mutex_lock(&q->mutex);
+    q->stopping = true;
+    pthread_cond_signal(&q->filled);
+    pthread_mutex_unlock(&q->mutex);
+    pthread_join(q->thread, NULL);
+    pthread_cond_destroy(&q->drained);
+    pthread_cond_destroy(&q->filled);
+    pthread_mutex_destroy(&q->mutex);
+#endif // _WIN32
+
+    bool ok = !q->failed;
+    // NOTE: always reap the ffmpeg process, even after a failed write
+    if (!ffmpeg_end_rendering(q->ffmpeg))
+        ok = false;
+    if (stats != NULL)
+        *stats = q->stats;
+    encoder_free(q);
+    return ok;
+}
@@ -0,0 +1,42 @@
+#ifndef ENCODER_H_
+#define ENCODER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ffmpeg.h"
+#include "y4m.h"
+
+typedef void Encoder;
+
+typedef struct {
+    size_t frames;    // frames handed over to ffmpeg
+    size_t repeats;   // of which repeated by encoder_repeat()
+    size_t stalls;    // times encoder_acquire() found the queue full
+    double wait_time; // seconds spent waiting in encoder_acquire()
+    // seconds spent writing into ffmpeg, i.e. mostly waiting for it to read
+    double write_time;
+    FFMPEG_Progress ffmpeg; // the last report of ffmpeg
+} Encoder_Stats;
+
+// the encoder owns `ffmpeg` and feeds it from a writer thread through a
+// queue of `queue` frames of `frame_size` bytes each
+// NOTE: on Windows the frames are written synchronously by encoder_submit()
+Encoder *encoder_start(FFMPEG *ffmpeg, size_t frame_size, size_t queue);
+// the encoder owns `y4m` and the frames are written right into its mapping:
+// encoder_acquire() returns the next frame of the file
+Encoder *encoder_start_y4m(Y4M_Writer *y4m);
+// a free frame buffer to fill, waiting for the writer if the queue is full;
+// NULL when writing into ffmpeg has failed
+void *encoder_acquire(Encoder *encoder);
+// queue the frame returned by the last encoder_acquire()
+void encoder_submit(Encoder *encoder);
+// queue the last submitted frame once more, without copying it; not to be
+// called between encoder_acquire() and encoder_submit()
+void encoder_repeat(Encoder *encoder);
+// the stats so far
+void encoder_stats(Encoder *encoder, Encoder_Stats *stats);
+// write the queued frames and end the ffmpeg process; `stats` may be NULL
+bool encoder_stop(Encoder *encoder, Encoder_Stats *stats);
+
+#endif // ENCODER_H_
@@ -1,3 +1,6 @@
+#ifdef __linux__
+#define _GNU_SOURCE // F_SETPIPE_SZ & vmsplice()
+#endif              // __linux__
 #include "raylib.h"
 #include <assert.h>
 #include <errno.h>
@@ -6,33 +9,74 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/uio.h>
+#endif // __linux__
 
-#define READ_END  0
-#define WRITE_END 1
+#define READ_END        0
+#define WRITE_END       1
+#define PROGRESS_FD     3 // ffmpeg writes its `-progress` there
+
+#define FFMPEG_PIPE_SIZE (1 << 20) // the default /proc/sys/fs/pipe-max-size
 
 typedef struct {
     int pid;
     int pipe;
+    size_t pipe_size;
+    bool splice;
+    int progress; // read end of the `-progress` pipe
+    char progress_line[256];
+    size_t progress_count;
 } FFMPEG;
 
-FFMPEG *ffmpeg_start_rendering(size_t width, size_t height, size_t fps,
-                               const char *sound_file_path)
+#define FFMPEG_IMPLEMENTATION
+#include "ffmpeg.h"
+
+FFMPEG *ffmpeg_start_rendering(const Render_Profile *profile,
+                               const Render_Audio *audio)
 {
     int pipefd[2];
+    int progressfd[2];
 
     if (pipe(pipefd) < 0) {
         TraceLog(LOG_ERROR, "FFMPEG: Could not create a pipe: %s",
                  strerror(errno));
         return NULL;
     }
+    if (pipe(progressfd) < 0) {
+        TraceLog(LOG_ERROR, "FFMPEG: Could not create a pipe: %s",
+                 strerror(errno));
+        close(pipefd[READ_END]);
+        close(pipefd[WRITE_END]);
+        return NULL;
+    }
+    // the reports are read along the frames, which must not wait for them
+    fcntl(progressfd[READ_END], F_SETFL, O_NONBLOCK);
+    // NOTE: the other children (e.g. another ffmpeg) must not keep the ends
+    //       of the parent open, ffmpeg would never see the end of its input
+    fcntl(pipefd[WRITE_END], F_SETFD, FD_CLOEXEC);
+    fcntl(progressfd[READ_END], F_SETFD, FD_CLOEXEC);
+
+    // NOTE: the command is built before fork() so the child doesn't allocate
+    size_t temp_checkpoint = nob_temp_save();
+    Nob_Cmd cmd = {0};
+    nob_cmd_append(&cmd, "ffmpeg", "-progress",
+                   nob_temp_sprintf("pipe:%d", PROGRESS_FD));
+    render_profile_ffmpeg_args(profile, audio, &cmd);
+    nob_cmd_append(&cmd, NULL);
 
     pid_t child = fork();
     if (child < 0) {
         TraceLog(LOG_ERROR, "FFMPEG: could not fork a child: %s",
                  strerror(errno));
+        close(progressfd[READ_END]);
+        close(progressfd[WRITE_END]);
+        nob_cmd_free(cmd);
+        nob_temp_rewind(temp_checkpoint);
         return NULL;
     }
 
@@ -45,21 +89,18 @@ FFMPEG *ffmpeg_start_rendering(size_t width, size_t height, size_t fps,
             exit(1);
         }
         close(pipefd[WRITE_END]);
+        close(progressfd[READ_END]);
+        if (progressfd[WRITE_END] != PROGRESS_FD) {
+            if (dup2(progressfd[WRITE_END], PROGRESS_FD) < 0) {
+                TraceLog(LOG_ERROR,
+                         "FFMPEG CHILD: could not reopen the progress pipe: %s",
+                         strerror(errno));
+                exit(1);
+            }
+            close(progressfd[WRITE_END]);
+        }
 
-        char resolution[64];
-        snprintf(resolution, sizeof(resolution), "%zux%zu", width, height);
-        char framerate[64];
-        snprintf(framerate, sizeof(framerate), "%zu", fps);
-
-        int ret = execlp("ffmpeg", "ffmpeg", "-loglevel", "verbose", "-y",
-
-                         "-f", "rawvideo", "-pix_fmt", "rgba", "-s", resolution,
-                         "-r", framerate, "-i", "-", "-i", sound_file_path,
-
-                         "-c:v", "libx264", "-vb", "2500k", "-c:a", "aac",
-                         "-ab", "200k", "-pix_fmt", "yuv420p", "output.mp4",
-
-                         NULL);
+        int ret = execvp(cmd.items[0], (char *const *)cmd.items);
         if (ret < 0) {
             TraceLog(
                 LOG_ERROR,
@@ -71,6 +112,10 @@ FFMPEG *ffmpeg_start_rendering(size_t width, size_t height, size_t fps,
         exit(1);
     }
 
+    nob_cmd_free(cmd);
+    nob_temp_rewind(temp_checkpoint);
+
+    close(progressfd[WRITE_END]);
     if (close(pipefd[READ_END]) < 0) {
         TraceLog(LOG_WARNING,
                  "FFMPEG: could not close read end of the pipe on the parent's "
@@ -82,13 +127,79 @@ FFMPEG *ffmpeg_start_rendering(size_t width, size_t height, size_t fps,
     assert(ffmpeg != NULL && "Buy MORE RAM lol!!");
     ffmpeg->pid = child;
     ffmpeg->pipe = pipefd[WRITE_END];
+    ffmpeg->pipe_size = 0;
+    ffmpeg->splice = false;
+    ffmpeg->progress = progressfd[READ_END];
+    ffmpeg->progress_count = 0;
+
+#ifdef __linux__
+    // a bigger pipe means fewer trips through the scheduler per frame
+    if (fcntl(ffmpeg->pipe, F_SETPIPE_SZ, FFMPEG_PIPE_SIZE) < 0) {
+        TraceLog(LOG_WARNING, "FFMPEG: could not resize the pipe: %s",
+                 strerror(errno));
+    }
+    int pipe_size = fcntl(ffmpeg->pipe, F_GETPIPE_SZ);
+    if (pipe_size > 0) {
+        ffmpeg->pipe_size = pipe_size;
+        ffmpeg->splice = true;
+    }
+#endif // __linux__
+
     return ffmpeg;
 }
 
+// parse the `key=value` lines of the reports
+static bool ffmpeg_parse_progress(FFMPEG *ffmpeg, const char *data, size_t size,
+                                  FFMPEG_Progress *progress)
+{
+    bool updated = false;
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] != '\n') {
+            // NOTE: the lines we care about are short, the others may be cut
+            if (ffmpeg->progress_count + 1 < sizeof(ffmpeg->progress_line))
+                ffmpeg->progress_line[ffmpeg->progress_count++] = data[i];
+            continue;
+        }
+        char *line = ffmpeg->progress_line;
+        line[ffmpeg->progress_count] = '\0';
+        ffmpeg->progress_count = 0;
+
+        if (strncmp(line, "frame=", 6) == 0) {
+            progress->frame = strtoull(line + 6, NULL, 10);
+            updated = true;
+        } else if (strncmp(line, "fps=", 4) == 0) {
+            progress->fps = strtof(line + 4, NULL);
+            updated = true;
+        } else if (strncmp(line, "speed=", 6) == 0) {
+            // e.g. `speed=1.23x` or `speed=N/A`
+            progress->speed = strtof(line + 6, NULL);
+            updated = true;
+        }
+    }
+    return updated;
+}
+
+bool ffmpeg_progress(FFMPEG *ffmpeg, FFMPEG_Progress *progress)
+{
+    bool updated = false;
+    char buffer[1024];
+    for (;;) {
+        ssize_t n = read(ffmpeg->progress, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        if (ffmpeg_parse_progress(ffmpeg, buffer, n, progress))
+            updated = true;
+    }
+    return updated;
+}
+
 bool ffmpeg_end_rendering(FFMPEG *ffmpeg)
 {
     int pipe = ffmpeg->pipe;
     pid_t pid = ffmpeg->pid;
+    int progress = ffmpeg->progress;
 
     free(ffmpeg);
 
@@ -99,6 +210,19 @@ bool ffmpeg_end_rendering(FFMPEG *ffmpeg)
                  strerror(errno));
     }
 
+    // NOTE: ffmpeg writes its last report on the way out, which must not find
+    //       the pipe closed, so it's drained until ffmpeg closes it
+    fcntl(progress, F_SETFL, 0);
+    char buffer[1024];
+    for (;;) {
+        ssize_t n = read(progress, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+    }
+    close(progress);
+
     for (;;) {
         int wstatus = 0;
         if (waitpid(pid, &wstatus, 0) < 0) {
@@ -130,18 +254,57 @@ bool ffmpeg_end_rendering(FFMPEG *ffmpeg)
     assert(0 && "unreachable");
 }
 
-bool ffmpeg_send_frame_flipped(FFMPEG *ffmpeg, void *data, size_t width,
-                               size_t height)
+static bool ffmpeg_write(FFMPEG *ffmpeg, const char *data, size_t size)
 {
-    for (size_t y = height; y > 0; --y) {
-        // TODO: write() may not necessarily write the entire row. We may want
-        // to repeat the call.
-        if (write(ffmpeg->pipe, (uint32_t *)data + (y - 1) * width,
-                  sizeof(uint32_t) * width) < 0) {
+    while (size > 0) {
+        ssize_t n = write(ffmpeg->pipe, data, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
             TraceLog(LOG_ERROR, "FFMPEG: failed to write into ffmpeg pipe: %s",
                      strerror(errno));
             return false;
         }
+        data += n;
+        size -= n;
     }
     return true;
 }
+
+bool ffmpeg_send_frame(FFMPEG *ffmpeg, const void *data, size_t size)
+{
+    const char *bytes = data;
+
+#ifdef __linux__
+    // NOTE: vmsplice() lends the pages of the frame to the pipe instead of
+    // copying them, but the pipe refers to them until ffmpeg reads them. So
+    // the last pipe-full goes through a regular write(): once it's in the
+    // pipe, every spliced page has been consumed and the caller may reuse
+    // the frame.
+    if (ffmpeg->splice && size > ffmpeg->pipe_size) {
+        size_t spliced = size - ffmpeg->pipe_size;
+        while (spliced > 0) {
+            struct iovec iov = {
+                .iov_base = (void *)bytes,
+                .iov_len = spliced,
+            };
+            ssize_t n = vmsplice(ffmpeg->pipe, &iov, 1, 0);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                // e.g. the pages of a mapped GPU buffer can't be spliced;
+                // ffmpeg_write() reports the errors that matter
+                TraceLog(LOG_DEBUG, "FFMPEG: vmsplice() failed: %s",
+                         strerror(errno));
+                ffmpeg->splice = false;
+                break;
+            }
+            bytes += n;
+            size -= n;
+            spliced -= n;
+        }
+    }
+#endif // __linux__
+
+    return ffmpeg_write(ffmpeg, bytes, size);
+}
@@ -4,12 +4,30 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "profile.h"
+
+// NOTE: ffmpeg.c and ffmpeg_windows.c define FFMPEG before including this
+#ifndef FFMPEG_IMPLEMENTATION
 typedef void FFMPEG;
+#endif // FFMPEG_IMPLEMENTATION
+
+// what ffmpeg reports through `-progress`
+typedef struct {
+    size_t frame; // frames encoded so far
+    float fps;    // encoding speed
+    float speed;  // encoding speed relative to the duration of the video
+} FFMPEG_Progress;
 
-FFMPEG *ffmpeg_start_rendering(size_t width, size_t height, size_t fps,
-                               const char *audio_file_path);
-bool ffmpeg_send_frame_flipped(FFMPEG *ffmpeg, void *data, size_t width,
-                               size_t height);
+// `audio` is NULL for a video without sound
+FFMPEG *ffmpeg_start_rendering(const Render_Profile *profile,
+                               const Render_Audio *audio);
+// `data` holds a whole frame, top row first, which goes out in one go
+bool ffmpeg_send_frame(FFMPEG *ffmpeg, const void *data, size_t size);
 bool ffmpeg_end_rendering(FFMPEG *ffmpeg);
+// update `progress` with what ffmpeg has reported since the last call,
+// without blocking; false if there was nothing new
+// NOTE: ffmpeg stops encoding when the reports are not read, so it's meant to
+//       be called after each frame by the thread that sends them
+bool ffmpeg_progress(FFMPEG *ffmpeg, FFMPEG_Progress *progress);
 
 #endif // FFMPEG_H_
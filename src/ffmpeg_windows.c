@@ -2,6 +2,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define WIN32_LEAN_AND_MEAN
 #define _WINUSER_
@@ -15,10 +17,16 @@
 typedef struct {
     HANDLE hProcess;
     HANDLE hPipeWrite;
+    HANDLE hProgressRead; // ffmpeg writes its `-progress` on its stdout
+    char progress_line[256];
+    size_t progress_count;
 } FFMPEG;
 
-FFMPEG *ffmpeg_start_rendering(size_t width, size_t height, size_t fps,
-                               const char *sound_file_path)
+#define FFMPEG_IMPLEMENTATION
+#include "ffmpeg.h"
+
+FFMPEG *ffmpeg_start_rendering(const Render_Profile *profile,
+                               const Render_Audio *audio)
 {
     HANDLE pipe_read;
     HANDLE pipe_write;
@@ -42,6 +50,28 @@ FFMPEG *ffmpeg_start_rendering(size_t width, size_t height, size_t fps,
         return NULL;
     }
 
+    HANDLE progress_read;
+    HANDLE progress_write;
+    if (!CreatePipe(&progress_read, &progress_write, &saAttr, 0)) {
+        TraceLog(LOG_ERROR,
+                 "FFMPEG: Could not create pipe. System Error Code: %d",
+                 GetLastError());
+        CloseHandle(pipe_write);
+        CloseHandle(pipe_read);
+        return NULL;
+    }
+    if (!SetHandleInformation(progress_read, HANDLE_FLAG_INHERIT, 0)) {
+        TraceLog(LOG_ERROR,
+                 "FFMPEG: Could not mark read pipe as non-inheritable. System "
+                 "Error Code: %d",
+                 GetLastError());
+        CloseHandle(progress_write);
+        CloseHandle(progress_read);
+        CloseHandle(pipe_write);
+        CloseHandle(pipe_read);
+        return NULL;
+    }
+
     // https://docs.microsoft.com/en-us/windows/win32/procthread/creating-a-child-process-with-redirected-input-and-output
 
     STARTUPINFO siStartInfo;
@@ -57,42 +87,56 @@ FFMPEG *ffmpeg_start_rendering(size_t width, size_t height, size_t fps,
                  GetLastError());
         return NULL;
     }
-    siStartInfo.hStdOutput = GetStdHandle(STD_OUTPUT_HANDLE);
-    if (siStartInfo.hStdOutput == INVALID_HANDLE_VALUE) {
-        TraceLog(LOG_ERROR,
-                 "FFMPEG: Could get standard output handle for the child. "
-                 "System Error Code: %d",
-                 GetLastError());
-        return NULL;
-    }
+    // NOTE: nothing else goes to the stdout of ffmpeg when it writes into a
+    //       file, it's the `-progress` pipe
+    siStartInfo.hStdOutput = progress_write;
     siStartInfo.hStdInput = pipe_read;
     siStartInfo.dwFlags |= STARTF_USESTDHANDLES;
 
     PROCESS_INFORMATION piProcInfo;
     ZeroMemory(&piProcInfo, sizeof(PROCESS_INFORMATION));
 
-    // TODO: use String_Builder in here
-    // TODO: sanitize user input through sound_file_path
-    char cmd_buffer[1024 * 2];
-    snprintf(cmd_buffer, sizeof(cmd_buffer),
-             "ffmpeg.exe -loglevel verbose -y -f rawvideo -pix_fmt rgba -s "
-             "%dx%d -r %d -i - -i \"%s\" -c:v libx264 -vb 2500k -c:a aac -ab "
-             "200k -pix_fmt yuv420p output.mp4",
-             (int)width, (int)height, (int)fps, sound_file_path);
-
-    if (!CreateProcess(NULL, cmd_buffer, NULL, NULL, TRUE, 0, NULL, NULL,
-                       &siStartInfo, &piProcInfo)) {
+    // TODO: sanitize user input through audio->file_path
+    size_t temp_checkpoint = nob_temp_save();
+    Nob_Cmd cmd = {0};
+    nob_cmd_append(&cmd, "ffmpeg.exe", "-progress", "pipe:1");
+    render_profile_ffmpeg_args(profile, audio, &cmd);
+    // NOTE: nob_cmd_render() quotes with ' which CreateProcess() ignores
+    Nob_String_Builder cmd_buffer = {0};
+    for (size_t i = 0; i < cmd.count; ++i) {
+        const char *arg = cmd.items[i];
+        if (i > 0)
+            nob_sb_append_cstr(&cmd_buffer, " ");
+        if (strchr(arg, ' ') == NULL) {
+            nob_sb_append_cstr(&cmd_buffer, arg);
+        } else {
+            nob_da_append(&cmd_buffer, '"');
+            nob_sb_append_cstr(&cmd_buffer, arg);
+            nob_da_append(&cmd_buffer, '"');
+        }
+    }
+    nob_sb_append_null(&cmd_buffer);
+    nob_cmd_free(cmd);
+    nob_temp_rewind(temp_checkpoint);
+
+    BOOL created = CreateProcess(NULL, cmd_buffer.items, NULL, NULL, TRUE, 0,
+                                 NULL, NULL, &siStartInfo, &piProcInfo);
+    nob_sb_free(cmd_buffer);
+    if (!created) {
         TraceLog(
             LOG_ERROR,
             "FFMPEG: Could not create child process. System Error Code: %d",
             GetLastError());
 
+        CloseHandle(progress_write);
+        CloseHandle(progress_read);
         CloseHandle(pipe_write);
         CloseHandle(pipe_read);
 
         return NULL;
     }
 
+    CloseHandle(progress_write);
     CloseHandle(pipe_read);
     CloseHandle(piProcInfo.hThread);
 
@@ -100,35 +144,103 @@ FFMPEG *ffmpeg_start_rendering(size_t width, size_t height, size_t fps,
     assert(ffmpeg != NULL && "Buy MORE RAM lol!!");
     ffmpeg->hProcess = piProcInfo.hProcess;
     ffmpeg->hPipeWrite = pipe_write;
+    ffmpeg->hProgressRead = progress_read;
+    ffmpeg->progress_count = 0;
     return ffmpeg;
 }
 
-bool ffmpeg_send_frame_flipped(FFMPEG *ffmpeg, void *data, size_t width,
-                               size_t height)
+bool ffmpeg_send_frame(FFMPEG *ffmpeg, const void *data, size_t size)
 {
-    for (size_t y = height; y > 0; --y) {
+    const char *bytes = data;
+    while (size > 0) {
+        DWORD written = 0;
         // TODO: handle ERROR_IO_PENDING
-        if (!WriteFile(ffmpeg->hPipeWrite, (uint32_t *)data + (y - 1) * width,
-                       sizeof(uint32_t) * width, NULL, NULL)) {
+        if (!WriteFile(ffmpeg->hPipeWrite, bytes, size, &written, NULL)) {
             TraceLog(LOG_ERROR,
                      "FFMPEG: failed to write into ffmpeg pipe. System Error "
                      "Code: %d",
                      GetLastError());
             return false;
         }
+        bytes += written;
+        size -= written;
     }
     return true;
 }
 
+// parse the `key=value` lines of the reports
+static bool ffmpeg_parse_progress(FFMPEG *ffmpeg, const char *data, size_t size,
+                                  FFMPEG_Progress *progress)
+{
+    bool updated = false;
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] != '\n') {
+            // NOTE: the lines we care about are short, the others may be cut
+            if (ffmpeg->progress_count + 1 < sizeof(ffmpeg->progress_line))
+                ffmpeg->progress_line[ffmpeg->progress_count++] = data[i];
+            continue;
+        }
+        char *line = ffmpeg->progress_line;
+        line[ffmpeg->progress_count] = '\0';
+        ffmpeg->progress_count = 0;
+
+        if (strncmp(line, "frame=", 6) == 0) {
+            progress->frame = strtoull(line + 6, NULL, 10);
+            updated = true;
+        } else if (strncmp(line, "fps=", 4) == 0) {
+            progress->fps = strtof(line + 4, NULL);
+            updated = true;
+        } else if (strncmp(line, "speed=", 6) == 0) {
+            // e.g. `speed=1.23x` or `speed=N/A`
+            progress->speed = strtof(line + 6, NULL);
+            updated = true;
+        }
+    }
+    return updated;
+}
+
+bool ffmpeg_progress(FFMPEG *ffmpeg, FFMPEG_Progress *progress)
+{
+    bool updated = false;
+    char buffer[1024];
+    for (;;) {
+        // NOTE: an anonymous pipe can't be made non-blocking, only what's
+        //       already in it is read
+        DWORD available = 0;
+        if (!PeekNamedPipe(ffmpeg->hProgressRead, NULL, 0, NULL, &available,
+                           NULL) ||
+            available == 0)
+            break;
+        DWORD n = 0;
+        if (available > sizeof(buffer))
+            available = sizeof(buffer);
+        if (!ReadFile(ffmpeg->hProgressRead, buffer, available, &n, NULL) ||
+            n == 0)
+            break;
+        if (ffmpeg_parse_progress(ffmpeg, buffer, n, progress))
+            updated = true;
+    }
+    return updated;
+}
+
 bool ffmpeg_end_rendering(FFMPEG *ffmpeg)
 {
     HANDLE hPipeWrite = ffmpeg->hPipeWrite;
     HANDLE hProcess = ffmpeg->hProcess;
+    HANDLE hProgressRead = ffmpeg->hProgressRead;
     free(ffmpeg);
 
     FlushFileBuffers(hPipeWrite);
     CloseHandle(hPipeWrite);
 
+    // NOTE: ffmpeg writes its last report on the way out, which must not find
+    //       the pipe closed, so it's drained until ffmpeg closes it
+    char buffer[1024];
+    DWORD n = 0;
+    while (ReadFile(hProgressRead, buffer, sizeof(buffer), &n, NULL) && n > 0)
+        ;
+    CloseHandle(hProgressRead);
+
     if (WaitForSingleObject(hProcess, INFINITE) == WAIT_FAILED) {
         TraceLog(
             LOG_ERROR,
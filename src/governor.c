@@ -0,0 +1,97 @@
+#include "governor.h"
+#include "raylib.h"
+#include <string.h>
+
+// NOTE: the GL functions are the ones raylib loaded with glad
+#include "external/glad.h"
+
+// the weight of a frame in the averages
+#define GOVERNOR_SMOOTHING 0.1
+
+void governor_init(Governor *g, double budget, size_t tier_count)
+{
+    memset(g, 0, sizeof(*g));
+    g->budget = budget;
+    g->tier_count = tier_count;
+    // NOTE: GL_TIME_ELAPSED is core since OpenGL 3.3
+    if (glGenQueries != NULL)
+        glGenQueries(GOVERNOR_QUERIES, g->queries);
+    if (g->queries[0] == 0)
+        TraceLog(LOG_WARNING, "GOVERNOR: no timer queries, the GPU time of a "
+                              "frame is not measured");
+}
+
+void governor_free(Governor *g)
+{
+    if (g->queries[0] != 0)
+        glDeleteQueries(GOVERNOR_QUERIES, g->queries);
+    memset(g->queries, 0, sizeof(g->queries));
+    memset(g->pending, 0, sizeof(g->pending));
+}
+
+void governor_begin_gpu(Governor *g)
+{
+    g->querying = false;
+    if (g->queries[0] == 0)
+        return;
+
+    size_t i = g->head;
+    if (g->pending[i]) {
+        GLint available = 0;
+        glGetQueryObjectiv(g->queries[i], GL_QUERY_RESULT_AVAILABLE,
+                           &available);
+        if (!available)
+            return;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(g->queries[i], GL_QUERY_RESULT, &elapsed);
+        g->gpu += (elapsed * 1e-9 - g->gpu) * GOVERNOR_SMOOTHING;
+        g->pending[i] = false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, g->queries[i]);
+    g->querying = true;
+}
+
+void governor_end_gpu(Governor *g)
+{
+    if (!g->querying)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    g->pending[g->head] = true;
+    g->head = (g->head + 1) % GOVERNOR_QUERIES;
+    g->querying = false;
+}
+
+bool governor_frame(Governor *g, double cpu, double dt)
+{
+    g->cpu += (cpu - g->cpu) * GOVERNOR_SMOOTHING;
+    double load = (g->cpu > g->gpu ? g->cpu : g->gpu) / g->budget;
+
+    // NOTE: a frame after a wait for events, or at the slower rates of a
+    //       window in the background, takes longer without any work; it
+    //       counts as one frame of the budget and no more
+    if (dt > g->budget)
+        dt = g->budget;
+    g->cooldown -= dt;
+    if (g->cooldown > 0)
+        return false;
+
+    if (load > GOVERNOR_HIGH) {
+        g->headroom = 0;
+        if (g->tier + 1 >= g->tier_count)
+            return false;
+        g->tier += 1;
+    } else if (load < GOVERNOR_LOW) {
+        g->headroom += dt;
+        if (g->headroom < GOVERNOR_RECOVERY_SECS || g->tier == 0)
+            return false;
+        g->headroom = 0;
+        g->tier -= 1;
+    } else {
+        g->headroom = 0;
+        return false;
+    }
+    g->cooldown = GOVERNOR_COOLDOWN_SECS;
+    TraceLog(LOG_INFO, "GOVERNOR: tier %zu (cpu %.1f ms, gpu %.1f ms)",
+             g->tier, g->cpu * 1000, g->gpu * 1000);
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef GOVERNOR_H_
+#define GOVERNOR_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define GOVERNOR_QUERIES 4
+
+// NOTE: keeps the frames of the UI within a budget by choosing among
+//       `tier_count` tiers of quality (0 is the best one): the CPU time of a
+//       frame is measured by the caller and its GPU time by timer queries
+//       that are read a few frames later, so nothing waits for the GPU; when
+//       the slower of the two goes over GOVERNOR_HIGH of the budget, the
+//       quality goes a tier down and it goes back up once they stay under
+//       GOVERNOR_LOW of it for GOVERNOR_RECOVERY_SECS
+#define GOVERNOR_HIGH           0.9
+#define GOVERNOR_LOW            0.5
+#define GOVERNOR_RECOVERY_SECS  3.0
+// between two changes of tier, so the averages catch up with the new one
+#define GOVERNOR_COOLDOWN_SECS  1.0
+typedef struct {
+    size_t tier;
+    size_t tier_count;
+    double budget; // seconds per frame
+    double cpu;    // average seconds per frame
+    double gpu;    // average seconds per frame, 0 without timer queries
+    double cooldown;
+    double headroom; // seconds under GOVERNOR_LOW of the budget
+
+    // NOTE: a ring of GL_TIME_ELAPSED queries
+    unsigned int queries[GOVERNOR_QUERIES];
+    bool pending[GOVERNOR_QUERIES];
+    size_t head;
+    bool querying; // between governor_begin_gpu() & governor_end_gpu()
+} Governor;
+
+void governor_init(Governor *g, double budget, size_t tier_count);
+// release the timer queries
+void governor_free(Governor *g);
+// the GPU time of what's drawn until governor_end_gpu() is measured, unless
+// the query this frame would use is still in flight
+void governor_begin_gpu(Governor *g);
+void governor_end_gpu(Governor *g);
+// account for a frame that took `cpu` seconds of work on the CPU, `dt`
+// seconds after the previous one (counted up to the budget, the cooldown and
+// the recovery go by frames of the budget); true if the tier changed
+bool governor_frame(Governor *g, double cpu, double dt);
+
+#endif // GOVERNOR_H_
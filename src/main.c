@@ -1,8 +1,11 @@
 #include <assert.h>
 #include <raylib.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "plug.h"
+#include "render_cli.h"
 
 #ifndef _WIN32
 #include <signal.h> // needed for sigaction()
@@ -10,7 +13,95 @@
 
 #include "hotreload.h"
 
-int main()
+static bool parse_frame(const char *arg, size_t *frame)
+{
+    if (strcmp(arg, "end") == 0) {
+        *frame = RENDER_JOB_END;
+        return true;
+    }
+    char *end = NULL;
+    *frame = strtoull(arg, &end, 10);
+    return *arg != '\0' && *end == '\0';
+}
+
+// `musicalizer segment [--software] [--loop <first> <last>] <track> <profile>
+// <first frame> <last frame|end> <output>`: the worker of a segmented render
+// (see segment.h)
+static int render_segment(int argc, char **argv)
+{
+    bool software = argc > 0 && strcmp(argv[0], "--software") == 0;
+    if (software) {
+        argc -= 1;
+        argv += 1;
+    }
+
+    Render_Job job = {0};
+    bool usage = false;
+    if (argc > 0 && strcmp(argv[0], "--loop") == 0) {
+        job.loop = true;
+        usage = argc < 3 || !parse_frame(argv[1], &job.loop_first) ||
+                !parse_frame(argv[2], &job.loop_last) ||
+                job.loop_last == RENDER_JOB_END;
+        argc -= 3;
+        argv += 3;
+    }
+    if (usage || argc != 5 || !parse_frame(argv[2], &job.first_frame) ||
+        !parse_frame(argv[3], &job.last_frame)) {
+        fprintf(stderr, "Usage: musicalizer segment [--software] [--loop "
+                        "<first> <last>] <track> <profile> <first frame> "
+                        "<last frame|end> <output>\n");
+        return 1;
+    }
+    job.file_path = argv[0];
+    job.profile = argv[1];
+    job.output = argv[4];
+    job.video_only = true;
+
+    if (!reload_libplug())
+        return 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+    if (software) // no window and no GL context at all
+        return plug_render(&job, NULL) ? 0 : 1;
+
+    // NOTE: the GL context needs a window, which nobody has to see
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(64, 64, "Musicalizer (segment)");
+    plug_init();
+    bool ok = plug_render(&job, NULL);
+    plug_deinit();
+    CloseWindow();
+
+    return ok ? 0 : 1;
+}
+
+// `musicalizer analyze <track>... [-p <profile>]`: the analysis of the tracks
+// for the renders at the fps of the profile (`default` otherwise) to come
+// (see spectrum.h)
+static int analyze(int argc, char **argv)
+{
+    const char *profile = "default";
+    if (argc >= 2 && strcmp(argv[argc - 2], "-p") == 0) {
+        profile = argv[argc - 1];
+        argc -= 2;
+    }
+    if (argc == 0) {
+        fprintf(stderr, "Usage: musicalizer analyze <track>... [-p "
+                        "<profile>]\n");
+        return 1;
+    }
+
+    if (!reload_libplug())
+        return 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+    bool ok = true;
+    for (int i = 0; i < argc; ++i)
+        ok = plug_analyze(argv[i], profile) && ok;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
 {
 #ifndef _WIN32
     // NOTE: This is needed because if the pipe between this program and FFmpeg
@@ -23,6 +114,15 @@ int main()
     sigaction(SIGPIPE, &act, NULL);
 #endif // _WIN32
 
+    if (argc > 1 && strcmp(argv[1], "segment") == 0)
+        return render_segment(argc - 2, argv + 2);
+    if (argc > 1 && strcmp(argv[1], "render") == 0)
+        return render_cli(argc - 2, argv + 2);
+    if (argc > 1 && strcmp(argv[1], "render-worker") == 0)
+        return render_cli_worker(argc - 2, argv + 2);
+    if (argc > 1 && strcmp(argv[1], "analyze") == 0)
+        return analyze(argc - 2, argv + 2);
+
     if (!reload_libplug())
         return 1;
 
@@ -49,6 +149,7 @@ int main()
         plug_update();
     }
 
+    plug_deinit();
     CloseAudioDevice();
     CloseWindow();
 
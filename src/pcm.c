@@ -0,0 +1,304 @@
+#include "pcm.h"
+#include "raylib.h"
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define _WINUSER_
+#define _WINGDI_
+#define _IMM_
+#define _WINCON_
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#define WAVE_FORMAT_PCM        0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+static uint16_t le16(const unsigned char *b)
+{
+    return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+static uint32_t le32(const unsigned char *b)
+{
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) |
+           ((uint32_t)b[3] << 24);
+}
+
+void *pcm_map_file(const char *file_path, size_t *size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        TraceLog(LOG_ERROR, "PCM: could not open %s. System Error Code: %d",
+                 file_path, GetLastError());
+        return NULL;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        TraceLog(LOG_ERROR, "PCM: could not get the size of %s", file_path);
+        CloseHandle(file);
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        TraceLog(LOG_ERROR, "PCM: could not map %s. System Error Code: %d",
+                 file_path, GetLastError());
+        return NULL;
+    }
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL) {
+        TraceLog(LOG_ERROR, "PCM: could not map %s. System Error Code: %d",
+                 file_path, GetLastError());
+        return NULL;
+    }
+    *size = (size_t)file_size.QuadPart;
+    return data;
+#else
+    int fd = open(file_path, O_RDONLY);
+    if (fd < 0) {
+        TraceLog(LOG_ERROR, "PCM: could not open %s: %s", file_path,
+                 strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        TraceLog(LOG_ERROR, "PCM: could not get the size of %s", file_path);
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        TraceLog(LOG_ERROR, "PCM: could not map %s: %s", file_path,
+                 strerror(errno));
+        return NULL;
+    }
+    // the renderer goes through the file from start to finish
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    *size = st.st_size;
+    return data;
+#endif // _WIN32
+}
+
+void pcm_unmap_file(void *data, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif // _WIN32
+}
+
+static const char *raw_extension(const char *file_path)
+{
+    const char *ext = GetFileExtension(file_path);
+    if (ext == NULL)
+        return NULL;
+    if (strcmp(ext, ".f32le") == 0 || strcmp(ext, ".s16le") == 0)
+        return ext;
+    return NULL;
+}
+
+const char *pcm_raw_format(const char *file_path)
+{
+    const char *ext = raw_extension(file_path);
+    return ext != NULL ? ext + 1 : NULL;
+}
+
+static bool pcm_parse_wav(const char *file_path, Pcm *pcm)
+{
+    const unsigned char *b = pcm->map;
+    size_t size = pcm->map_size;
+
+    if (size < 12 || memcmp(b, "RIFF", 4) != 0 || memcmp(b + 8, "WAVE", 4) != 0)
+        return false;
+
+    unsigned int format = 0;
+    unsigned int bits = 0;
+    size_t block_align = 0;
+    bool has_fmt = false;
+
+    for (size_t at = 12; at + 8 <= size;) {
+        const unsigned char *chunk = b + at;
+        size_t chunk_size = le32(chunk + 4);
+        size_t body = at + 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunk_size < 16 || body + chunk_size > size)
+                return false;
+            format = le16(b + body);
+            pcm->channels = le16(b + body + 2);
+            pcm->sample_rate = le32(b + body + 4);
+            block_align = le16(b + body + 12);
+            bits = le16(b + body + 14);
+            if (format == WAVE_FORMAT_EXTENSIBLE && chunk_size >= 40) {
+                // the first two bytes of the sub-format GUID
+                format = le16(b + body + 24);
+            }
+            has_fmt = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!has_fmt || block_align == 0 || pcm->channels == 0)
+                return false;
+            // some encoders leave the size of a streamed data chunk unset
+            if (chunk_size > size - body)
+                chunk_size = size - body;
+            pcm->frames = b + body;
+            pcm->frame_size = block_align;
+            pcm->frame_count = chunk_size / block_align;
+            break;
+        }
+
+        // chunks are word aligned
+        at = body + chunk_size + (chunk_size & 1);
+    }
+
+    if (pcm->frames == NULL)
+        return false;
+
+    if (format == WAVE_FORMAT_PCM) {
+        switch (bits) {
+        case 8:
+            pcm->format = PCM_U8;
+            break;
+        case 16:
+            pcm->format = PCM_S16;
+            break;
+        case 24:
+            pcm->format = PCM_S24;
+            break;
+        case 32:
+            pcm->format = PCM_S32;
+            break;
+        default:
+            TraceLog(LOG_WARNING, "PCM: %s: unsupported %u-bit samples",
+                     file_path, bits);
+            return false;
+        }
+    } else if (format == WAVE_FORMAT_IEEE_FLOAT) {
+        if (bits == 32) {
+            pcm->format = PCM_F32;
+        } else if (bits == 64) {
+            pcm->format = PCM_F64;
+        } else {
+            TraceLog(LOG_WARNING, "PCM: %s: unsupported %u-bit floats",
+                     file_path, bits);
+            return false;
+        }
+    } else {
+        TraceLog(LOG_WARNING, "PCM: %s: unsupported WAV format 0x%04X",
+                 file_path, format);
+        return false;
+    }
+
+    if (block_align < (size_t)pcm->channels * (bits / 8))
+        return false;
+
+    return true;
+}
+
+bool pcm_open(const char *file_path, Pcm *pcm)
+{
+    memset(pcm, 0, sizeof(*pcm));
+
+    const char *raw = raw_extension(file_path);
+    if (raw == NULL && !IsFileExtension(file_path, ".wav"))
+        return false;
+
+    pcm->map = pcm_map_file(file_path, &pcm->map_size);
+    if (pcm->map == NULL)
+        return false;
+
+    if (raw != NULL) {
+        pcm->format = strcmp(raw, ".f32le") == 0 ? PCM_F32 : PCM_S16;
+        pcm->channels = PCM_RAW_CHANNELS;
+        pcm->sample_rate = PCM_RAW_SAMPLE_RATE;
+        pcm->frame_size = PCM_RAW_CHANNELS * (pcm->format == PCM_F32 ? 4 : 2);
+        pcm->frames = pcm->map;
+        pcm->frame_count = pcm->map_size / pcm->frame_size;
+    } else if (!pcm_parse_wav(file_path, pcm)) {
+        TraceLog(LOG_WARNING, "PCM: %s is not a WAV file we can map",
+                 file_path);
+        pcm_close(pcm);
+        return false;
+    }
+
+    TraceLog(LOG_INFO, "PCM: mapped %s (%zu frames, %u Hz, %u channels)",
+             file_path, pcm->frame_count, pcm->sample_rate, pcm->channels);
+    return true;
+}
+
+void pcm_close(Pcm *pcm)
+{
+    if (pcm->map != NULL)
+        pcm_unmap_file(pcm->map, pcm->map_size);
+    memset(pcm, 0, sizeof(*pcm));
+}
+
+void pcm_read(const Pcm *pcm, size_t frame, unsigned int channel, float *out,
+              size_t count)
+{
+    size_t available = 0;
+    if (frame < pcm->frame_count)
+        available = pcm->frame_count - frame;
+    if (available > count)
+        available = count;
+
+    const unsigned char *s = pcm->frames;
+    if (available > 0)
+        s += frame * pcm->frame_size;
+    switch (pcm->format) {
+    case PCM_U8:
+        s += channel;
+        for (size_t i = 0; i < available; ++i, s += pcm->frame_size)
+            out[i] = ((float)s[0] - 128.0f) / 128.0f;
+        break;
+    case PCM_S16:
+        s += channel * 2;
+        for (size_t i = 0; i < available; ++i, s += pcm->frame_size)
+            out[i] = (int16_t)le16(s) / 32768.0f;
+        break;
+    case PCM_S24:
+        s += channel * 3;
+        for (size_t i = 0; i < available; ++i, s += pcm->frame_size) {
+            int32_t v = (int32_t)(((uint32_t)s[0] << 8) |
+                                  ((uint32_t)s[1] << 16) |
+                                  ((uint32_t)s[2] << 24));
+            out[i] = (v >> 8) / 8388608.0f;
+        }
+        break;
+    case PCM_S32:
+        s += channel * 4;
+        for (size_t i = 0; i < available; ++i, s += pcm->frame_size)
+            out[i] = (int32_t)le32(s) / 2147483648.0f;
+        break;
+    case PCM_F32:
+        s += channel * 4;
+        for (size_t i = 0; i < available; ++i, s += pcm->frame_size)
+            memcpy(&out[i], s, sizeof(float));
+        break;
+    case PCM_F64:
+        s += channel * 8;
+        for (size_t i = 0; i < available; ++i, s += pcm->frame_size) {
+            double d;
+            memcpy(&d, s, sizeof(double));
+            out[i] = (float)d;
+        }
+        break;
+    }
+
+    for (size_t i = available; i < count; ++i)
+        out[i] = 0.0f;
+}
@@ -0,0 +1,48 @@
+#ifndef PCM_H_
+#define PCM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+    PCM_U8,
+    PCM_S16,
+    PCM_S24,
+    PCM_S32,
+    PCM_F32,
+    PCM_F64,
+} Pcm_Format;
+
+// NOTE: a PCM file memory-mapped as is; the frames are read (and converted to
+//       float) straight from the mapping so nothing is copied on the heap
+typedef struct {
+    void *map;
+    size_t map_size;
+    const unsigned char *frames; // first PCM frame within the mapping
+    size_t frame_count;
+    size_t frame_size; // in bytes, all channels included
+    unsigned int sample_rate;
+    unsigned int channels;
+    Pcm_Format format;
+} Pcm;
+
+#define PCM_RAW_SAMPLE_RATE 44100
+#define PCM_RAW_CHANNELS    2
+
+// WAV (PCM or IEEE float) and raw files; the raw files (`.f32le` and
+// `.s16le`) are expected to be `PCM_RAW_SAMPLE_RATE` Hz and
+// `PCM_RAW_CHANNELS` channels
+bool pcm_open(const char *file_path, Pcm *pcm);
+void pcm_close(Pcm *pcm);
+// convert `count` frames of `channel` starting at `frame` into `out`; the
+// frames past the end are zeroed
+void pcm_read(const Pcm *pcm, size_t frame, unsigned int channel, float *out,
+              size_t count);
+// the name ffmpeg gives to the format of a raw file ("f32le" or "s16le"),
+// NULL for any other file
+const char *pcm_raw_format(const char *file_path);
+
+void *pcm_map_file(const char *file_path, size_t *size);
+void pcm_unmap_file(void *data, size_t size);
+
+#endif // PCM_H_
@@ -1,10 +1,24 @@
 #include "plug.h"
+#include "bands.h"
+#include "bloom.h"
+#include "checkpoint.h"
+#include "clock.h"
+#include "decoder.h"
+#include "encoder.h"
 #include "ffmpeg.h"
+#include "governor.h"
+#include "pcm.h"
+#include "profile.h"
 #include "raylib.h"
+#include "readback.h"
+#include "segment.h"
+#include "softrender.h"
+#include "spectrum.h"
 #include <assert.h>
 #include <complex.h>
 #include <math.h>
 #include <rlgl.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,12 +34,20 @@
 #define GLSL_VERSION                  330
 
 #define N                             (1 << 13)
+// the ratio between the frequencies of two bands of the analysis
+#define FFT_BAND_STEP                 1.06f
 #define FONT_SIZE                     64
-
-#define RENDER_FPS                    30
-#define RENDER_FACTOR                 100
-#define RENDER_WIDTH                  (16 * RENDER_FACTOR)
-#define RENDER_HEIGHT                 (9 * RENDER_FACTOR)
+#define FONT_PATH                     "./resources/fonts/Alegreya-Regular.ttf"
+
+#define RENDER_BATCH_SECS             0.1
+#define RENDER_READBACK_RING          3
+#define RENDER_ENCODER_QUEUE          4
+#define RENDER_PREROLL_SECS           3
+#define RENDER_LOOP_FADE_SECS         0.5
+#define RENDER_MAX_OUTPUTS            4
+// the values of two frames that are the same once multiplied by this are
+// deemed to look the same (a pixel is way coarser)
+#define RENDER_STATIC_QUANTUM         4096.0f
 
 #define COLOR_ACCENT                  ColorFromHSV(225, 0.75, 0.8)
 #define COLOR_BACKGROUND              GetColor(0x151515FF)
@@ -36,6 +58,8 @@
 #define COLOR_TRACK_BUTTON_SELECTED COLOR_ACCENT
 #define COLOR_TIMELINE_CURSOR       COLOR_ACCENT
 #define COLOR_TIMELINE_BACKGROUND   ColorBrightness(COLOR_BACKGROUND, -0.3)
+#define COLOR_TIMELINE_REGION       ColorAlpha(COLOR_ACCENT, 0.3)
+#define COLOR_TIMELINE_LOOP         ColorAlpha(COLOR_ACCENT, 0.5)
 #define COLOR_HUD_BUTTON_BACKGROUND COLOR_TRACK_BUTTON_BACKGROUND
 #define COLOR_HUD_BUTTON_HOVEROVER  COLOR_TRACK_BUTTON_HOVEROVER
 #define HUD_TIMER_SECS              1.0f
@@ -43,6 +67,19 @@
 #define HUD_BUTTON_MARGIN           50
 #define HUD_ICON_SCALE              0.5
 
+// the UI waits for input once nothing has moved for a while (see plug_idle())
+#define IDLE_AFTER_SECS             (HUD_TIMER_SECS + 0.5f)
+#define IDLE_ACTIVE_FPS             60
+// NOTE: the music is fed by UpdateMusicStream() once a frame and raylib
+//       streams it through 2 buffers of 1/30 s: a window in the background
+//       playing a track must stay above 30 fps
+#define IDLE_BACKGROUND_FPS         40
+// in the background with nothing playing, until the bands are at rest
+#define IDLE_SETTLING_FPS           15
+// the time the UI has to draw a frame before the governor lowers the quality
+// of the preview (see quality_tiers)
+#define QUALITY_BUDGET_SECS         (1.0 / IDLE_ACTIVE_FPS)
+
 // Microsoft could not update their parser OMEGALUL:
 // https://learn.microsoft.com/en-us/cpp/c-runtime-library/complex-math-support?view=msvc-170#types-used-in-complex-math
 #ifdef _MSC_VER
@@ -64,6 +101,17 @@
 typedef struct {
     char *file_path;
     Music music;
+    // the region that gets rendered, in seconds (`region_out` at 0 is the
+    // end of the track) and whether the video loops over it
+    float region_in;
+    float region_out;
+    bool loop;
+    // the name in the tracks panel cut to its width, made again when the size
+    // of the text or the room for it change (see track_label())
+    char *label;
+    float label_font_size;
+    float label_width;
+    Vector2 label_size; // measured
 } Track;
 
 typedef struct {
@@ -118,6 +166,63 @@ typedef struct {
     Textures textures;
 } Assets;
 
+// where the time of a rendered frame goes
+typedef enum {
+    RENDER_STAGE_DECODE,
+    RENDER_STAGE_ANALYSIS,
+    RENDER_STAGE_DRAW,
+    RENDER_STAGE_READBACK, // glReadPixels() and the copy for the encoder
+    RENDER_STAGE_ENCODER,  // waiting for a free frame, i.e. for ffmpeg
+    RENDER_STAGE_COUNT,
+} Render_Stage;
+
+static const char *render_stage_names[RENDER_STAGE_COUNT] = {
+    [RENDER_STAGE_DECODE] = "decode",
+    [RENDER_STAGE_ANALYSIS] = "analysis",
+    [RENDER_STAGE_DRAW] = "draw",
+    [RENDER_STAGE_READBACK] = "readback",
+    [RENDER_STAGE_ENCODER] = "ffmpeg",
+};
+
+// what the preview trades for time when the frames of the UI take longer than
+// QUALITY_BUDGET_SECS (see governor.h); the renders always use the profile
+typedef struct {
+    const char *name;
+    float scale;     // of the resolution the bands are drawn at, upscaled
+    float band_step; // the FFT_BAND_STEP: fewer bands when it's larger
+    size_t fft_size; // samples of the analysis window, a power of 2 up to N
+    bool glow;       // the glowing circles
+} Quality_Tier;
+
+static const Quality_Tier quality_tiers[] = {
+    {"high", 1.0f, FFT_BAND_STEP, N, true},
+    {"medium", 0.75f, FFT_BAND_STEP, N, true},
+    {"low", 0.5f, 1.12f, N / 2, true},
+    {"lowest", 0.5f, 1.12f, N / 4, false},
+};
+
+// one of the videos made by a render: the profile and the `also` of it share
+// the analysis of every frame, each one is drawn at its own size and encoded
+// by its own ffmpeg
+typedef struct {
+    Render_Profile profile;
+    RenderTexture2D screen;
+    RenderTexture2D yuv; // `screen` packed in yuv420p (see yuv420.fs)
+    bool packed_yuv;
+    Soft_Renderer *softrender; // the profile draws without OpenGL
+    Readback readback;
+    Encoder *encoder;
+    Bloom bloom; // the levels of the glow of `screen` (`glow = bloom`)
+} Render_Output;
+
+// a part of the UI drawn into a texture once and then drawn as a single quad
+// until the state it shows changes (see ui_layer_begin())
+typedef struct {
+    RenderTexture2D target;
+    uint64_t key;
+    bool valid; // false: drawn again by the next ui_layer_begin()
+} Ui_Layer;
+
 typedef struct {
     Assets assets;
 
@@ -125,18 +230,82 @@ typedef struct {
     Tracks tracks;
     int current_track;
     Font font;
+    bool font_sdf; // the glyphs are distance fields drawn through `sdf`
+    Shader sdf;
     Shader circle;
     int circle_radius_location;
     int circle_power_location;
+    Shader yuv420;
+    int yuv420_size_location;
+    Bands bands; // fft_render() in a draw call per layer
+    Bloom_Shader bloom;
     bool fullscreen;
+    // the parts of the UI that only change on input
+    Ui_Layer ui_tracks;
+    Ui_Layer ui_timeline; // without its cursor
+    Ui_Layer ui_fullscreen;
+    Ui_Layer ui_volume;
+    bool fft_still;        // the bands look the same from a frame to the next
+    double last_input;     // GetTime() of the last input
+    int target_fps;        // 0: waiting for events (see plug_idle())
+    // the tier of quality_tiers the preview is drawn at
+    Governor governor;
+    double frame_started;    // clock_now() when plug_update() began
+    RenderTexture2D preview; // the bands at the scale of the tier, if below 1
+    bool governor_hud;       // toggled by F3
 
     // renderer
     bool rendering;
-    RenderTexture2D screen;
+    bool render_vsync; // vsync was on before the render started
+    Render_Profiles profiles;
+    size_t profile;                // selected in `profiles`
+    Render_Profile render_profile; // the one used by the current render
+    // `render_profile` first, then the profiles of its `also`
+    Render_Output outputs[RENDER_MAX_OUTPUTS];
+    size_t output_count;
+    bool render_segmented; // by worker processes (see segment.h)
+    Segments segments;
+    size_t render_first_frame;
+    size_t render_frame_index;
+    size_t render_last_frame;
+    // the last frames of a loop fade into the state of its first one
+    size_t render_loop_last;
+    size_t render_loop_fade; // 0: not a loop
+    float loop_smooth[N];
+    float loop_smear[N];
+    // the frames that look like the previous one are not drawn but repeated
+    // by the encoder (see render_frame())
+    bool render_hashed;
+    uint64_t render_hash;
+    size_t render_silence; // trailing silent samples of the analysis window
+    size_t render_bins;    // the `m` of the last analysis
+    // seconds spent in each stage: in total, for the frame being rendered
+    // and per frame on average over the last ones
+    double render_started;
+    double render_stage_total[RENDER_STAGE_COUNT];
+    double render_stage_frame[RENDER_STAGE_COUNT];
+    double render_stage_average[RENDER_STAGE_COUNT];
+    bool render_stats_file; // written next to the output
+    // a profile with `checkpoint` writes its video in parts, closing one and
+    // saving where the render got to every so many frames so an interrupted
+    // render resumes from there (see checkpoint.h); the parts are joined
+    // along with `render_audio` at the end
+    size_t render_checkpoint; // frames per part, 0: not checkpointed
+    size_t render_part;       // the one being written
+    size_t render_part_first; // its first frame
+    Nob_String_Builder render_key;
+    Render_Audio render_audio;
+    // NOTE: when the track can be mapped (see pcm.h) or decoded by the pool
+    //       (see decoder.h), `wave` only carries the metadata and
+    //       `wave_samples` stays NULL
+    Pcm pcm;
+    Decoder *decoder;
     Wave wave;
     float *wave_samples;
+    // the analysis of the track done beforehand, which replaces the source
+    // when there's one (see spectrum.h)
+    Spectrum spectrum;
     size_t wave_cursor;
-    FFMPEG *ffmpeg;
 
     // FFT analyzer
     float in_raw[N];
@@ -248,28 +417,60 @@ static inline float amp(Float_Complex z)
     return logf(a * a + b * b);
 }
 
-static size_t fft_analyze(float dt)
+// smooth out and smear the `m` values of `out_log`
+static void fft_smooth(size_t m, float dt)
+{
+    float smoothness = 8;
+    float smearness = 3;
+    // NOTE: the first frame after the UI waited for events comes after a
+    //       long time, it must not overshoot
+    float smooth = smoothness * dt < 1.0f ? smoothness * dt : 1.0f;
+    float smear = smearness * dt < 1.0f ? smearness * dt : 1.0f;
+    for (size_t i = 0; i < m; ++i) {
+        p->out_smooth[i] += (p->out_log[i] - p->out_smooth[i]) * smooth;
+        p->out_smear[i] += (p->out_smooth[i] - p->out_smear[i]) * smear;
+    }
+}
+
+// the `m` smoothed bands reached the analysis and the smears reached them
+static bool fft_at_rest(size_t m)
+{
+    float eps = 1e-3;
+    for (size_t i = 0; i < m; ++i) {
+        if (fabsf(p->out_log[i] - p->out_smooth[i]) > eps)
+            return false;
+        if (fabsf(p->out_smooth[i] - p->out_smear[i]) > eps)
+            return false;
+    }
+    return true;
+}
+
+// the log bands of the last `n` samples of the analysis window (a power of 2
+// up to N) into `out_log`, a band every `step` of frequency; returns their
+// count
+static size_t fft_bands(size_t n, float step)
 {
+    assert(n <= N);
+    const float *in = p->in_raw + N - n;
 
     // Hann function to smoothen the input (it enhances the output)
-    for (size_t i = 0; i < N; ++i) {
-        float t = (float)i / (N - 1);
+    for (size_t i = 0; i < n; ++i) {
+        float t = (float)i / (n - 1);
         float hann = 0.5 - 0.5 * cosf(2 * PI * t);
-        p->in_win[i] = p->in_raw[i] * hann;
+        p->in_win[i] = in[i] * hann;
     }
 
     // FFT
-    fft(p->in_win, 1, p->out_raw, N);
+    fft(p->in_win, 1, p->out_raw, n);
 
     // squash into the logarithmic scale
-    float step = 1.06f;
     float lowf = 1.0f;
     size_t m = 0;
     float max_amp = 1.0f;
-    for (float f = lowf; (size_t)f < N / 2; f = ceilf(f * step)) {
+    for (float f = lowf; (size_t)f < n / 2; f = ceilf(f * step)) {
         float f1 = ceilf(f * step);
         float a = 0.0f;
-        for (size_t q = (size_t)f; q < N / 2 && q < (size_t)f1; ++q) {
+        for (size_t q = (size_t)f; q < n / 2 && q < (size_t)f1; ++q) {
             float b = amp(p->out_raw[q]);
             if (b > a)
                 a = b;
@@ -284,16 +485,23 @@ static size_t fft_analyze(float dt)
         p->out_log[i] /= max_amp;
     }
 
+    return m;
+}
+
+static size_t fft_analyze(float dt)
+{
+    size_t m = fft_bands(N, FFT_BAND_STEP);
     // smooth out and smear the values
-    float smoothness = 8;
-    float smearness = 3;
-    for (size_t i = 0; i < m; ++i) {
-        p->out_smooth[i] +=
-            (p->out_log[i] - p->out_smooth[i]) * smoothness * dt;
-        p->out_smear[i] +=
-            (p->out_smooth[i] - p->out_smear[i]) * smearness * dt;
-    }
+    fft_smooth(m, dt);
+    return m;
+}
 
+// fft_analyze() for the preview, at the quality chosen by the governor
+static size_t fft_analyze_preview(float dt)
+{
+    const Quality_Tier *tier = &quality_tiers[p->governor.tier];
+    size_t m = fft_bands(tier->fft_size, tier->band_step);
+    fft_smooth(m, dt);
     return m;
 }
 
@@ -303,6 +511,15 @@ static void fft_push(float frame)
     p->in_raw[N - 1] = frame;
 }
 
+// shift the analysis window by `count` samples and return its tail so the
+// caller can fill it in place
+static float *fft_push_many(size_t count)
+{
+    assert(count <= N);
+    memmove(p->in_raw, p->in_raw + count, (N - count) * sizeof(p->in_raw[0]));
+    return p->in_raw + N - count;
+}
+
 static void callback(void *bufferData, unsigned int frames)
 {
 
@@ -324,6 +541,132 @@ static void ma_callback(ma_device *pDevice, void *pOutput, const void *pInput,
 }
 #endif // FEATURE_MICROPHONE
 
+static void render_source_open(const char *file_path)
+{
+    p->wave_cursor = 0;
+    if (pcm_open(file_path, &p->pcm)) {
+        p->wave = CLITERAL(Wave){
+            .frameCount = p->pcm.frame_count,
+            .sampleRate = p->pcm.sample_rate,
+            .sampleSize = 32,
+            .channels = p->pcm.channels,
+        };
+        p->wave_samples = NULL;
+        return;
+    }
+    Decoder_Info info = {0};
+    p->decoder = decoder_start(file_path, 0, &info);
+    if (p->decoder != NULL) {
+        p->wave = CLITERAL(Wave){
+            .frameCount = info.frame_count,
+            .sampleRate = info.sample_rate,
+            .sampleSize = 32,
+            .channels = info.channels,
+        };
+        p->wave_samples = NULL;
+        return;
+    }
+    // TODO: LoadWave is pretty slow on big files
+    p->wave = LoadWave(file_path);
+    p->wave_samples = LoadWaveSamples(p->wave);
+}
+
+// the analysis of the track done beforehand when it matches, in place of the
+// track itself, which is then neither decoded nor analysed
+static bool render_spectrum_open(const char *file_path, size_t fps)
+{
+    Spectrum_Info expected = {.n = N, .fps = fps, .band_step = FFT_BAND_STEP};
+    if (!spectrum_open(file_path, &expected, &p->spectrum))
+        return false;
+    p->wave_cursor = 0;
+    p->wave = CLITERAL(Wave){
+        .frameCount = p->spectrum.info.source_frames,
+        .sampleRate = p->spectrum.info.sample_rate,
+        .sampleSize = 32,
+        .channels = 1,
+    };
+    p->wave_samples = NULL;
+    TraceLog(LOG_INFO, "RENDER: %s analysed beforehand (%zu frames)",
+             file_path, p->spectrum.info.frame_count);
+    return true;
+}
+
+// NOTE: a video frame does not always start on a sample (44100 Hz at 24 fps
+//       is 1837.5 samples a frame), the frames take 1837 or 1838 of them so
+//       they never drift from the audio
+
+// the first sample of `frame`
+static size_t render_frame_sample(size_t frame, size_t sample_rate, size_t fps)
+{
+    return (uint64_t)frame * sample_rate / fps;
+}
+
+// the first frame that starts at `sample` or after it
+static size_t render_sample_frame(size_t sample, size_t sample_rate,
+                                  size_t fps)
+{
+    if (sample_rate == 0)
+        return 0;
+    return ((uint64_t)sample * fps + sample_rate - 1) / sample_rate;
+}
+
+// the samples of the frame that starts at `wave_cursor`
+static size_t render_chunk_size(size_t fps)
+{
+    size_t rate = p->wave.sampleRate;
+    size_t frame = render_sample_frame(p->wave_cursor, rate, fps);
+    return render_frame_sample(frame + 1, rate, fps) - p->wave_cursor;
+}
+
+// the bands of the frame at `wave_cursor` out of the spectrum into `out_log`
+static size_t render_spectrum_read(size_t fps)
+{
+    size_t rate = p->wave.sampleRate;
+    size_t frame = render_sample_frame(p->wave_cursor, rate, fps);
+    spectrum_read(&p->spectrum, frame, p->out_log);
+    p->wave_cursor = render_frame_sample(frame + 1, rate, fps);
+    return p->spectrum.info.bins;
+}
+
+static void render_source_close()
+{
+    if (p->spectrum.map != NULL) {
+        spectrum_close(&p->spectrum);
+    } else if (p->pcm.map != NULL) {
+        pcm_close(&p->pcm);
+    } else if (p->decoder != NULL) {
+        decoder_stop(p->decoder);
+        p->decoder = NULL;
+    } else {
+        UnloadWave(p->wave);
+        UnloadWaveSamples(p->wave_samples);
+    }
+    p->wave = CLITERAL(Wave){0};
+    p->wave_samples = NULL;
+}
+
+// read the next `count` frames of the left channel into `out`
+static void render_source_read(float *out, size_t count)
+{
+    if (p->pcm.map != NULL) {
+        pcm_read(&p->pcm, p->wave_cursor, 0, out, count);
+    } else if (p->decoder != NULL) {
+        decoder_read(p->decoder, p->wave_cursor, out, count);
+    } else {
+        // https://cdecl.org/?q=float+%28*fs%29%5B2%5D
+        float *fs = p->wave_samples;
+        for (size_t i = 0; i < count; ++i) {
+            size_t cursor = p->wave_cursor + i;
+            if (cursor < p->wave.frameCount) {
+                out[i] = fs[cursor * p->wave.channels + 0];
+            } else {
+                out[i] = 0;
+            }
+        }
+    }
+    p->wave_cursor += count;
+}
+
 static Track *current_track()
 {
     if (0 <= p->current_track && (size_t)p->current_track < p->tracks.count) {
@@ -332,21 +675,27 @@ static Track *current_track()
     return NULL;
 }
 
-static void fft_render(Rectangle boundary, size_t m)
+// the circles are drawn at `circle_scale` of their size: 1, or their cores
+// only (BLOOM_CORE_SCALE) when the bloom makes their glow, 0: not at all
+static void fft_render(Rectangle boundary, size_t m, float circle_scale)
 {
 
+    if (bands_draw(&p->bands, boundary, p->out_smooth, p->out_smear, m,
+                   circle_scale))
+        return;
+
+    // NOTE: without bands.vs, every band is drawn on its own
+
     // width of a single bar
     float cell_width = (float)boundary.width / m;
 
-    // global color parameters
-    float saturation = 0.75f;
-    float value = 1.0f;
+    // a hue per band
+    const Color *colors = bands_colors(&p->bands, m);
 
     // display the bars
     for (size_t i = 0; i < m; ++i) {
         float t = p->out_smooth[i];
-        float hue = (float)i / m;
-        Color color = ColorFromHSV(hue * 360, saturation, value);
+        Color color = colors[i];
         Vector2 startPos = {
             boundary.x + i * cell_width + cell_width / 2,
             boundary.y + boundary.height - (float)boundary.height * 2 / 3 * t,
@@ -371,8 +720,7 @@ static void fft_render(Rectangle boundary, size_t m)
     for (size_t i = 0; i < m; ++i) {
         float start = p->out_smear[i];
         float end = p->out_smooth[i];
-        float hue = (float)i / m;
-        Color color = ColorFromHSV(hue * 360, saturation, value);
+        Color color = colors[i];
         Vector2 startPos = {
             boundary.x + i * cell_width + cell_width / 2,
             boundary.y + boundary.height -
@@ -404,28 +752,1054 @@ static void fft_render(Rectangle boundary, size_t m)
     }
     EndShaderMode();
 
+    if (circle_scale <= 0)
+        return;
+
     // display the circles
-    SetShaderValue(p->circle, p->circle_radius_location, (float[1]){0.07f},
+    SetShaderValue(p->circle, p->circle_radius_location,
+                   (float[1]){bands_circle_radius(circle_scale)},
                    SHADER_UNIFORM_FLOAT);
     SetShaderValue(p->circle, p->circle_power_location, (float[1]){5.0f},
                    SHADER_UNIFORM_FLOAT);
     BeginShaderMode(p->circle);
     for (size_t i = 0; i < m; ++i) {
         float t = p->out_smooth[i];
-        float hue = (float)i / m;
-        Color color = ColorFromHSV(hue * 360, saturation, value);
+        Color color = colors[i];
         Vector2 center = {
             boundary.x + i * cell_width + cell_width / 2,
             boundary.y + boundary.height - (float)boundary.height * 2 / 3 * t,
         };
-        float radius = cell_width * 6 * sqrtf(t);
+        float radius = cell_width * 6 * sqrtf(t) * circle_scale;
         Vector2 position = {
             .x = center.x - radius,
             .y = center.y - radius,
         };
         DrawTextureEx(texture, position, 0, 2 * radius, color);
     }
-    EndShaderMode();
+    EndShaderMode();
+}
+
+// NOTE: the alpha of a texture drawn into in this mode is the coverage of
+//       what's drawn (not its square), so the colours end up premultiplied
+//       by it and the texture goes on the screen with BLEND_ALPHA_PREMULTIPLY
+static void begin_premultiplied_blend_mode()
+{
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE,
+                              RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD,
+                              RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+}
+
+// fft_render() for the preview, clipped to `boundary`, at the quality chosen by
+// the governor: below the full resolution, the bands are drawn into `preview`
+// and upscaled into the boundary
+static void fft_render_preview(Rectangle boundary, size_t m)
+{
+    const Quality_Tier *tier = &quality_tiers[p->governor.tier];
+    float circle_scale = tier->glow ? 1.0f : 0.0f;
+    if (tier->scale >= 1.0f) {
+        // NOTE: no need for it until the governor lowers the resolution again
+        if (IsRenderTextureReady(p->preview)) {
+            UnloadRenderTexture(p->preview);
+            p->preview = (RenderTexture2D){0};
+        }
+        BeginScissorMode(boundary.x, boundary.y, boundary.width,
+                         boundary.height);
+        fft_render(boundary, m, circle_scale);
+        EndScissorMode();
+        return;
+    }
+
+    int w = boundary.width * tier->scale;
+    int h = boundary.height * tier->scale;
+    if (w <= 0 || h <= 0)
+        return;
+    if (p->preview.texture.width != w || p->preview.texture.height != h) {
+        UnloadRenderTexture(p->preview);
+        p->preview = LoadRenderTexture(w, h);
+        SetTextureFilter(p->preview.texture, TEXTURE_FILTER_BILINEAR);
+    }
+
+    BeginTextureMode(p->preview);
+    ClearBackground(BLANK);
+    begin_premultiplied_blend_mode();
+    fft_render(CLITERAL(Rectangle){0, 0, w, h}, m, circle_scale);
+    EndBlendMode();
+    EndTextureMode();
+
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTexturePro(p->preview.texture, CLITERAL(Rectangle){0, 0, w, -h},
+                   boundary, CLITERAL(Vector2){0}, 0, WHITE);
+    EndBlendMode();
+}
+
+// charge the time since `*t` to `stage` and restart `*t`
+static void render_stage_end(Render_Stage stage, double *t)
+{
+    double now = clock_now();
+    p->render_stage_frame[stage] += now - *t;
+    p->render_stage_total[stage] += now - *t;
+    *t = now;
+}
+
+static void render_stages_next_frame()
+{
+    for (size_t i = 0; i < RENDER_STAGE_COUNT; ++i) {
+        double *average = &p->render_stage_average[i];
+        *average += (p->render_stage_frame[i] - *average) * 0.05;
+        p->render_stage_frame[i] = 0;
+    }
+}
+
+// the stage that takes the most time lately
+static Render_Stage render_bottleneck()
+{
+    Render_Stage bottleneck = 0;
+    for (size_t i = 1; i < RENDER_STAGE_COUNT; ++i) {
+        if (p->render_stage_average[i] > p->render_stage_average[bottleneck])
+            bottleneck = i;
+    }
+    return bottleneck;
+}
+
+// (re)load the render profiles and keep the selected one if it's still there
+static void render_profiles_reload()
+{
+    char selected[PROFILE_NAME_CAP] = {0};
+    if (p->profile < p->profiles.count)
+        strcpy(selected, p->profiles.items[p->profile].name);
+
+    if (!render_profiles_load(RENDER_PROFILES_PATH, &p->profiles) ||
+        p->profiles.count == 0) {
+        p->profiles.count = 0;
+        nob_da_append(&p->profiles, render_profile_default());
+    }
+
+    p->profile = 0;
+    for (size_t i = 0; i < p->profiles.count; ++i) {
+        if (strcmp(p->profiles.items[i].name, selected) == 0)
+            p->profile = i;
+    }
+}
+
+static void render_profile_next()
+{
+    render_profiles_reload();
+    p->profile = (p->profile + 1) % p->profiles.count;
+    TraceLog(LOG_INFO, "RENDER: profile %s",
+             p->profiles.items[p->profile].name);
+}
+
+// (re)allocate `screen` and `yuv` for the profile of `o` and return the one
+// that is read back
+static RenderTexture2D render_targets(Render_Output *o)
+{
+    Render_Profile *profile = &o->profile;
+    if ((size_t)o->screen.texture.width != profile->width ||
+        (size_t)o->screen.texture.height != profile->height) {
+        UnloadRenderTexture(o->screen);
+        o->screen = LoadRenderTexture(profile->width, profile->height);
+    }
+    // NOTE: the circles glow on their own without bloom.fs
+    profile->bloom = profile->bloom && p->bloom.shader.id != 0;
+    if (profile->bloom)
+        bloom_resize(&o->bloom, profile->width, profile->height);
+
+    // NOTE: the frames are converted to yuv420p on the GPU (a 4 bytes texel
+    //       is 4 samples, hence the width) unless the shader didn't compile
+    o->packed_yuv = strcmp(profile->pix_fmt, "yuv420p") == 0 &&
+                    profile->width % 4 == 0 &&
+                    p->yuv420.id != rlGetShaderIdDefault();
+    if (!o->packed_yuv) {
+        strcpy(profile->pix_fmt, "rgba");
+        return o->screen;
+    }
+
+    int width = profile->width / 4;
+    int height = profile->height * 3 / 2;
+    if (o->yuv.texture.width != width || o->yuv.texture.height != height) {
+        UnloadRenderTexture(o->yuv);
+        o->yuv = LoadRenderTexture(width, height);
+    }
+    return o->yuv;
+}
+
+// `render_profile` and the profiles listed by its `also` that can be rendered
+// along with it
+static void render_outputs_choose(const Render_Job *job)
+{
+    const Render_Profile *primary = &p->render_profile;
+    p->outputs[0].profile = *primary;
+    p->output_count = 1;
+    // NOTE: a segment is a part of one video (see segment.h)
+    if (job->video_only)
+        return;
+
+    Nob_String_View names = nob_sv_from_cstr(primary->also);
+    while (names.count > 0) {
+        Nob_String_View name = nob_sv_trim(nob_sv_chop_by_delim(&names, ','));
+        if (name.count == 0)
+            continue;
+
+        const Render_Profile *profile = NULL;
+        for (size_t i = 0; i < p->profiles.count && profile == NULL; ++i) {
+            if (nob_sv_eq(name, nob_sv_from_cstr(p->profiles.items[i].name)))
+                profile = &p->profiles.items[i];
+        }
+        if (profile == NULL) {
+            TraceLog(LOG_WARNING, "RENDER: no render profile " SV_Fmt " in %s",
+                     SV_Arg(name), RENDER_PROFILES_PATH);
+        } else if (profile->fps != primary->fps) {
+            // the frames come out of the same analysis
+            TraceLog(LOG_WARNING, "RENDER: %s is not at %zu fps like %s",
+                     profile->name, primary->fps, primary->name);
+        } else if (!profile->software && !IsWindowReady()) {
+            TraceLog(LOG_WARNING, "RENDER: %s needs a window", profile->name);
+        } else if (p->output_count == RENDER_MAX_OUTPUTS) {
+            TraceLog(LOG_WARNING, "RENDER: %s is one output too many (%d)",
+                     profile->name, RENDER_MAX_OUTPUTS);
+        } else {
+            p->outputs[p->output_count++].profile = *profile;
+        }
+    }
+}
+
+// whether every output of the render still has its ffmpeg going
+static bool render_encoding()
+{
+    for (size_t i = 0; i < p->output_count; ++i) {
+        if (p->outputs[i].encoder == NULL)
+            return false;
+    }
+    return p->output_count > 0;
+}
+
+// an output into a `.y4m` file is not encoded but written as is (see y4m.h)
+static bool render_is_y4m(const Render_Profile *profile)
+{
+    return IsFileExtension(profile->output, ".y4m");
+}
+
+// the frames left to render, give or take the fade out
+static size_t render_frames_left()
+{
+    if (p->render_last_frame != RENDER_JOB_END)
+        return p->render_last_frame - p->render_frame_index;
+    size_t fps = p->render_profile.fps;
+    size_t frames =
+        render_sample_frame(p->wave.frameCount, p->wave.sampleRate, fps);
+    if (frames < p->render_frame_index)
+        frames = p->render_frame_index;
+    return frames - p->render_frame_index + RENDER_PREROLL_SECS * fps;
+}
+
+static bool render_output_y4m(Render_Output *o)
+{
+    const Render_Profile *profile = &o->profile;
+    // NOTE: the GPU only packs yuv420p when the width is a multiple of 4
+    if (strcmp(profile->pix_fmt, "yuv420p") != 0) {
+        TraceLog(LOG_ERROR, "RENDER: %s needs yuv420p frames and a width "
+                            "multiple of 4",
+                 profile->output);
+        return false;
+    }
+    Y4M_Writer *y4m = y4m_start(profile->output, profile->width,
+                                profile->height, profile->fps,
+                                render_frames_left());
+    if (y4m == NULL)
+        return false;
+    o->encoder = encoder_start_y4m(y4m);
+    return true;
+}
+
+// start the ffmpeg process of `o`, into the part being written when the
+// render is checkpointed (the audio only comes with the join then)
+static bool render_output_encode(Render_Output *o, const Render_Audio *audio)
+{
+    if (render_is_y4m(&o->profile))
+        return render_output_y4m(o);
+
+    Render_Profile profile = o->profile;
+    if (p->render_checkpoint > 0) {
+        size_t temp_checkpoint = nob_temp_save();
+        const char *part = segment_part_path(profile.output, p->render_part);
+        bool fits = strlen(part) < sizeof(profile.output);
+        if (fits)
+            strcpy(profile.output, part);
+        nob_temp_rewind(temp_checkpoint);
+        if (!fits) {
+            TraceLog(LOG_ERROR, "RENDER: the parts of %s have too long a path",
+                     o->profile.output);
+            return false;
+        }
+        audio = NULL;
+    }
+
+    FFMPEG *ffmpeg = ffmpeg_start_rendering(&profile, audio);
+    if (ffmpeg == NULL)
+        return false;
+    size_t frame_size = o->softrender != NULL
+                            ? softrender_frame_size(o->softrender)
+                            : o->readback.frame_size;
+    o->encoder = encoder_start(ffmpeg, frame_size, RENDER_ENCODER_QUEUE);
+    return o->encoder != NULL;
+}
+
+// the targets and the ffmpeg process of `o`
+static bool render_output_start(Render_Output *o, const Render_Audio *audio)
+{
+    const Render_Profile *profile = &o->profile;
+    o->encoder = NULL;
+    if (profile->software) {
+        // the frames go straight from the CPU to the encoder
+        o->packed_yuv = false;
+        o->softrender =
+            softrender_start(profile->width, profile->height,
+                             strcmp(profile->pix_fmt, "yuv420p") == 0, 0);
+        if (o->softrender == NULL)
+            return false;
+    } else {
+        RenderTexture2D target = render_targets(o);
+        if (!readback_init(&o->readback, target.texture.width,
+                           target.texture.height, RENDER_READBACK_RING))
+            return false;
+    }
+    return render_output_encode(o, audio);
+}
+
+// `default + vertical + preview`
+static const char *render_outputs_label()
+{
+    static char label[RENDER_MAX_OUTPUTS * (PROFILE_NAME_CAP + 3)];
+    size_t n = 0;
+    label[0] = '\0';
+    for (size_t i = 0; i < p->output_count; ++i) {
+        n += snprintf(label + n, sizeof(label) - n, "%s%s", i > 0 ? " + " : "",
+                      p->outputs[i].profile.name);
+    }
+    return label;
+}
+
+// the audio that goes along the frames of `job`
+static Render_Audio render_job_audio(const Render_Job *job, size_t sample_rate,
+                                     size_t fps)
+{
+    Render_Audio audio = {
+        .file_path = job->file_path,
+        .format = pcm_raw_format(job->file_path),
+    };
+    if (sample_rate == 0)
+        return audio;
+    size_t first = render_frame_sample(job->first_frame, sample_rate, fps);
+    audio.start = (double)first / sample_rate;
+    if (job->last_frame != RENDER_JOB_END) {
+        size_t last = render_frame_sample(job->last_frame, sample_rate, fps);
+        audio.duration = (double)(last - first) / sample_rate;
+    }
+    return audio;
+}
+
+// NOTE: a render that starts in the middle of the track goes through the
+//       samples before `frame` first, so the analysis window and the
+//       smoothing are where they'd be if it had started from the beginning;
+//       in a loop, these samples wrap around to the end of the loop since
+//       that's what plays before its first frame
+static void render_preroll(const Render_Job *job, size_t frame)
+{
+    size_t fps = p->render_profile.fps;
+    size_t rate = p->wave.sampleRate;
+    size_t preroll = RENDER_PREROLL_SECS * fps;
+    if (!job->loop && preroll > frame)
+        preroll = frame;
+
+    for (size_t i = preroll; i > 0; --i) {
+        size_t f = frame - i;
+        if (job->loop) {
+            long long length = job->loop_last - job->loop_first;
+            long long offset =
+                ((long long)frame - (long long)i - job->loop_first) % length;
+            f = job->loop_first + (offset < 0 ? offset + length : offset);
+        }
+        p->wave_cursor = render_frame_sample(f, rate, fps);
+        if (p->spectrum.map != NULL) {
+            fft_smooth(render_spectrum_read(fps), 1.0f / fps);
+        } else {
+            size_t chunk_size = render_chunk_size(fps);
+            render_source_read(fft_push_many(chunk_size), chunk_size);
+            fft_analyze(1.0f / fps);
+        }
+    }
+    p->wave_cursor = render_frame_sample(frame, rate, fps);
+}
+
+#define RENDER_CHECKPOINT_CHUNKS   8
+#define render_checkpoint_chunk(x) ((Checkpoint_Chunk){&(x), sizeof(x)})
+
+// the state of the analysis that a checkpoint saves
+static size_t render_checkpoint_chunks(Checkpoint_Chunk *chunks)
+{
+    size_t n = 0;
+    chunks[n++] = render_checkpoint_chunk(p->in_raw);
+    chunks[n++] = render_checkpoint_chunk(p->out_smooth);
+    chunks[n++] = render_checkpoint_chunk(p->out_smear);
+    chunks[n++] = render_checkpoint_chunk(p->loop_smooth);
+    chunks[n++] = render_checkpoint_chunk(p->loop_smear);
+    chunks[n++] = render_checkpoint_chunk(p->render_silence);
+    chunks[n++] = render_checkpoint_chunk(p->render_bins);
+    chunks[n++] = render_checkpoint_chunk(p->render_stage_total);
+    return n;
+}
+
+static const char *render_checkpoint_path()
+{
+    return TextFormat("%s.checkpoint", p->outputs[0].profile.output);
+}
+
+// what a checkpoint must have been saved by to be resumed by `job`
+static void render_checkpoint_key(const Render_Job *job)
+{
+    Nob_String_Builder *key = &p->render_key;
+    key->count = 0;
+    nob_sb_append_cstr(key, TextFormat("%s %ld", job->file_path,
+                                       GetFileModTime(job->file_path)));
+    nob_sb_append_cstr(key, TextFormat(" %zu %zu", job->first_frame,
+                                       job->last_frame));
+    if (job->loop)
+        nob_sb_append_cstr(key, TextFormat(" loop %zu %zu", job->loop_first,
+                                           job->loop_last));
+    for (size_t i = 0; i < p->output_count; ++i) {
+        const Render_Profile *it = &p->outputs[i].profile;
+        nob_sb_append_cstr(key, TextFormat("\n%s %zux%zu@%zu %s %s %s %d %s",
+                                           it->name, it->width, it->height,
+                                           it->fps, it->pix_fmt, it->vcodec,
+                                           it->preset, it->crf, it->bitrate));
+        nob_sb_append_cstr(key, TextFormat(" %s %zu", it->output,
+                                           it->checkpoint));
+        // NOTE: the renderers and the glows don't draw the same frames, the
+        //       parts saved by one would not match the rest drawn by another
+        nob_sb_append_cstr(key, TextFormat(" software %d shader %d bloom %d",
+                                           it->software, it->single_pass,
+                                           it->bloom));
+    }
+    nob_sb_append_null(key);
+}
+
+static void render_checkpoint_save()
+{
+    Checkpoint cp = {
+        .parts = p->render_part,
+        .frame = p->render_frame_index,
+        .wave_cursor = p->wave_cursor,
+        .seconds = clock_now() - p->render_started,
+    };
+    Checkpoint_Chunk chunks[RENDER_CHECKPOINT_CHUNKS];
+    size_t count = render_checkpoint_chunks(chunks);
+    // NOTE: the render goes on without it, a resume would only go back further
+    checkpoint_save(render_checkpoint_path(), p->render_key.items, &cp, chunks,
+                    count);
+}
+
+// pick up where the last render of `job` stopped if it was checkpointed;
+// `seconds` is the time spent on the frames before
+static bool render_resume(const Render_Job *job, double *seconds)
+{
+    p->render_checkpoint = 0;
+    p->render_part = 0;
+    p->render_part_first = job->first_frame;
+    // NOTE: segments are parts already (see segment.h)
+    if (job->video_only || p->render_profile.checkpoint == 0)
+        return false;
+    for (size_t i = 0; i < p->output_count; ++i) {
+        if (render_is_y4m(&p->outputs[i].profile)) {
+            TraceLog(LOG_WARNING, "RENDER: %s is not checkpointed",
+                     p->outputs[i].profile.output);
+            return false;
+        }
+    }
+    p->render_checkpoint = p->render_profile.checkpoint * p->render_profile.fps;
+    render_checkpoint_key(job);
+
+    Checkpoint cp;
+    Checkpoint_Chunk chunks[RENDER_CHECKPOINT_CHUNKS];
+    size_t count = render_checkpoint_chunks(chunks);
+    if (!checkpoint_load(render_checkpoint_path(), p->render_key.items, &cp,
+                         chunks, count) ||
+        cp.frame < job->first_frame || cp.frame >= job->last_frame) {
+        fft_clean();
+        p->render_silence = 0;
+        p->render_bins = 0;
+        memset(p->render_stage_total, 0, sizeof(p->render_stage_total));
+        return false;
+    }
+
+    p->render_part = cp.parts;
+    p->render_part_first = cp.frame;
+    p->render_frame_index = cp.frame;
+    p->wave_cursor = cp.wave_cursor;
+    *seconds = cp.seconds;
+    TraceLog(LOG_INFO, "RENDER: resuming %s at frame %zu (%zu parts done)",
+             p->render_profile.output, cp.frame, cp.parts);
+    return true;
+}
+
+// set up `render_profile` (already chosen) for `job`: the outputs, the source,
+// the encoders and the analysis of the frames before `job->first_frame` (or
+// the state of the checkpoint it resumes from)
+static bool render_begin(const Render_Job *job)
+{
+    render_outputs_choose(job);
+    fft_clean();
+    size_t fps = p->render_profile.fps;
+    // NOTE: the analysis before the first frame of a loop wraps around to its
+    //       end, which the spectrum of the track doesn't know about
+    if (job->loop || !render_spectrum_open(job->file_path, fps))
+        render_source_open(job->file_path);
+    p->render_audio = render_job_audio(job, p->wave.sampleRate, fps);
+    p->render_hashed = false;
+    p->render_silence = 0;
+    p->render_bins = 0;
+    p->render_stats_file = !job->video_only;
+    memset(p->render_stage_total, 0, sizeof(p->render_stage_total));
+    memset(p->render_stage_frame, 0, sizeof(p->render_stage_frame));
+    memset(p->render_stage_average, 0, sizeof(p->render_stage_average));
+    p->render_first_frame = job->first_frame;
+    p->render_frame_index = job->first_frame;
+    p->render_last_frame = job->last_frame;
+    double seconds = 0;
+    bool resumed = render_resume(job, &seconds);
+
+    for (size_t i = 0; i < p->output_count; ++i) {
+        if (!render_output_start(&p->outputs[i],
+                                 job->video_only ? NULL : &p->render_audio))
+            break;
+    }
+    SetTraceLogLevel(LOG_WARNING);
+
+    // the state the loop starts with is needed by the frames that fade into
+    // it, which may not be the ones of this job (see segment.h)
+    p->render_loop_fade = 0;
+    if (job->loop) {
+        size_t length = job->loop_last - job->loop_first;
+        p->render_loop_last = job->loop_last;
+        p->render_loop_fade = RENDER_LOOP_FADE_SECS * fps;
+        if (p->render_loop_fade > length / 2)
+            p->render_loop_fade = length / 2;
+        if (!resumed &&
+            job->last_frame + p->render_loop_fade > job->loop_last) {
+            render_preroll(job, job->loop_first);
+            memcpy(p->loop_smooth, p->out_smooth, sizeof(p->loop_smooth));
+            memcpy(p->loop_smear, p->out_smear, sizeof(p->loop_smear));
+            fft_clean();
+        }
+    }
+    if (!resumed)
+        render_preroll(job, job->first_frame);
+    p->render_started = clock_now() - seconds;
+
+    // the render must not wait for the display
+    p->render_vsync = IsWindowState(FLAG_VSYNC_HINT);
+    if (p->render_vsync)
+        ClearWindowState(FLAG_VSYNC_HINT);
+
+    return render_encoding();
+}
+
+static void render_end()
+{
+    if (p->render_vsync)
+        SetWindowState(FLAG_VSYNC_HINT);
+    SetTraceLogLevel(LOG_INFO);
+    for (size_t i = 0; i < p->output_count; ++i) {
+        Render_Output *o = &p->outputs[i];
+        // NOTE: the outputs still going when another one failed
+        if (o->encoder != NULL) {
+            encoder_stop(o->encoder, NULL);
+            o->encoder = NULL;
+        }
+        readback_free(&o->readback);
+        if (o->softrender != NULL) {
+            softrender_stop(o->softrender);
+            o->softrender = NULL;
+        }
+    }
+    p->output_count = 0;
+    render_source_close();
+    fft_clean();
+}
+
+static void render_start(Track *track)
+{
+    StopMusicStream(track->music);
+
+    render_profiles_reload();
+    p->render_profile = p->profiles.items[p->profile];
+    p->rendering = true;
+
+    const Render_Profile *profile = &p->render_profile;
+    size_t sample_rate = track->music.stream.sampleRate;
+    size_t frame_count = 1;
+    if (sample_rate > 0)
+        frame_count = render_sample_frame(track->music.frameCount,
+                                          sample_rate, profile->fps);
+
+    Render_Job job = {
+        .file_path = track->file_path,
+        .profile = profile->name,
+        .first_frame = 0,
+        .last_frame = RENDER_JOB_END,
+    };
+    if (sample_rate > 0) {
+        job.first_frame = track->region_in * profile->fps;
+        if (track->region_out > 0)
+            job.last_frame = ceilf(track->region_out * profile->fps);
+        if (job.last_frame != RENDER_JOB_END && job.last_frame > frame_count)
+            job.last_frame = frame_count;
+        if (job.first_frame >= frame_count)
+            job.first_frame = 0;
+    }
+    if (track->loop) {
+        if (job.last_frame == RENDER_JOB_END)
+            job.last_frame = frame_count;
+        job.loop = job.last_frame > job.first_frame;
+        job.loop_first = job.first_frame;
+        job.loop_last = job.last_frame;
+    }
+
+    // NOTE: the parts are joined with the audio, which a Y4M file can't hold
+    p->render_segmented = profile->segments > 1 && !render_is_y4m(profile);
+    if (p->render_segmented) {
+        if (!segments_start(&p->segments, &job, profile, frame_count,
+                            render_job_audio(&job, sample_rate, profile->fps)))
+            p->segments.state = SEGMENTS_FAILED;
+        return;
+    }
+    render_begin(&job);
+}
+
+static void render_stop(Track *track)
+{
+    if (p->render_segmented) {
+        segments_free(&p->segments);
+        p->render_segmented = false;
+    } else {
+        render_end();
+    }
+    p->rendering = false;
+    PlayMusicStream(track->music);
+}
+
+static float render_progress()
+{
+    if (p->render_last_frame == RENDER_JOB_END)
+        return (float)p->wave_cursor / p->wave.frameCount;
+    return (float)(p->render_frame_index - p->render_first_frame) /
+           (p->render_last_frame - p->render_first_frame);
+}
+
+static bool render_done()
+{
+    if (p->render_frame_index >= p->render_last_frame)
+        return true;
+    return p->wave_cursor >= p->wave.frameCount && fft_settled();
+}
+
+// NOTE: glReadPixels() returns the bottom row first, so the frames for the
+//       encoder are drawn upside down and come out top row first
+static void begin_flipped_texture_mode(RenderTexture2D target)
+{
+    BeginTextureMode(target);
+    rlMatrixMode(RL_PROJECTION);
+    rlLoadIdentity();
+    rlOrtho(0, target.texture.width, 0, target.texture.height, 0.0f, 1.0f);
+    rlMatrixMode(RL_MODELVIEW);
+    // the flip turns the triangles around
+    rlDisableBackfaceCulling();
+}
+
+static void end_flipped_texture_mode()
+{
+    EndTextureMode();
+    rlEnableBackfaceCulling();
+}
+
+// pack `screen` into `yuv`, both planes and all
+static void render_yuv420(Render_Output *o)
+{
+    Texture2D texture = o->screen.texture;
+    Vector2 size = {texture.width, texture.height};
+    SetShaderValue(p->yuv420, p->yuv420_size_location, &size,
+                   SHADER_UNIFORM_VEC2);
+
+    BeginTextureMode(o->yuv);
+    // the alpha channel carries data too
+    rlDisableColorBlend();
+    BeginShaderMode(p->yuv420);
+    DrawTexturePro(texture, CLITERAL(Rectangle){0, 0, size.x, size.y},
+                   CLITERAL(Rectangle){0, 0, o->yuv.texture.width,
+                                       o->yuv.texture.height},
+                   CLITERAL(Vector2){0}, 0, WHITE);
+    EndShaderMode();
+    rlEnableColorBlend();
+    EndTextureMode();
+}
+
+static void render_json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s != '\0'; ++s) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\') {
+            fprintf(f, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+// `<output>.stats.json`: where the time of the render went
+static void render_write_stats(const Render_Output *o, const Encoder_Stats *s,
+                               bool ok)
+{
+    const char *path = TextFormat("%s.stats.json", o->profile.output);
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        TraceLog(LOG_WARNING, "RENDER: could not write %s", path);
+        return;
+    }
+
+    double seconds = clock_now() - p->render_started;
+    size_t frames = p->render_frame_index - p->render_first_frame;
+    fprintf(f, "{\n  \"profile\": ");
+    render_json_string(f, o->profile.name);
+    fprintf(f, ",\n  \"output\": ");
+    render_json_string(f, o->profile.output);
+    fprintf(f, ",\n  \"ok\": %s,\n", ok ? "true" : "false");
+    fprintf(f, "  \"frames\": %zu,\n", frames);
+    fprintf(f, "  \"repeated_frames\": %zu,\n", s->repeats);
+    fprintf(f, "  \"seconds\": %.3f,\n", seconds);
+    fprintf(f, "  \"fps\": %.2f,\n", seconds > 0 ? frames / seconds : 0.0);
+    fprintf(f, "  \"stages\": {");
+    for (size_t i = 0; i < RENDER_STAGE_COUNT; ++i) {
+        double total = p->render_stage_total[i];
+        fprintf(f,
+                "%s\n    \"%s\": {\"seconds\": %.3f, \"ms_per_frame\": "
+                "%.3f}",
+                i > 0 ? "," : "", render_stage_names[i], total,
+                frames > 0 ? total * 1000 / frames : 0.0);
+    }
+    fprintf(f, "\n  },\n");
+    fprintf(f,
+            "  \"encoder\": {\"stalls\": %zu, \"wait_seconds\": %.3f, "
+            "\"write_seconds\": %.3f},\n",
+            s->stalls, s->wait_time, s->write_time);
+    fprintf(f,
+            "  \"ffmpeg\": {\"frames\": %zu, \"fps\": %.2f, \"speed\": "
+            "%.3f}\n}\n",
+            s->ffmpeg.frame, s->ffmpeg.fps, s->ffmpeg.speed);
+    fclose(f);
+}
+
+// end the encoding of `o` and log how long the renderer was held up by
+// ffmpeg; `stats` may be NULL
+static bool render_end_encoding(Render_Output *o, Encoder_Stats *stats)
+{
+    Encoder_Stats s;
+    bool ok = encoder_stop(o->encoder, &s);
+    o->encoder = NULL;
+    TraceLog(LOG_WARNING,
+             "RENDER: %s: %zu frames (%zu repeated), waited %.2fs for the "
+             "encoder %zu times, %.2fs writing into ffmpeg",
+             o->profile.name, s.frames, s.repeats, s.wait_time, s.stalls,
+             s.write_time);
+    if (p->render_stats_file)
+        render_write_stats(o, &s, ok);
+    if (stats != NULL)
+        *stats = s;
+    return ok;
+}
+
+// end the encoding of every output, false if one of them failed; the frames
+// are the ones of the first output and the wait is the one of all of them
+static bool render_end_encodings(Render_Stats *stats)
+{
+    bool ok = true;
+    Render_Stats total = {0};
+    for (size_t i = 0; i < p->output_count; ++i) {
+        Render_Output *o = &p->outputs[i];
+        if (o->encoder == NULL) {
+            ok = false;
+            continue;
+        }
+        Encoder_Stats s;
+        ok = render_end_encoding(o, &s) && ok;
+        if (i == 0)
+            total.frames = s.frames;
+        total.encoder_wait += s.wait_time;
+    }
+    if (stats != NULL)
+        *stats = total;
+    return ok;
+}
+
+// queue the oldest frame of the readback ring of `o` for its encoder
+static void render_send_frame(Render_Output *o)
+{
+    double t = clock_now();
+    const void *data = readback_map(&o->readback);
+    render_stage_end(RENDER_STAGE_READBACK, &t);
+    void *frame = NULL;
+    if (data != NULL)
+        frame = encoder_acquire(o->encoder);
+    render_stage_end(RENDER_STAGE_ENCODER, &t);
+    if (frame != NULL) {
+        memcpy(frame, data, o->readback.frame_size);
+        encoder_submit(o->encoder);
+    } else {
+        render_end_encoding(o, NULL);
+    }
+    if (data != NULL)
+        readback_unmap(&o->readback);
+    render_stage_end(RENDER_STAGE_READBACK, &t);
+}
+
+// send the frames still in flight in the readback rings
+static void render_flush()
+{
+    for (size_t i = 0; i < p->output_count; ++i) {
+        Render_Output *o = &p->outputs[i];
+        while (o->encoder != NULL && o->readback.pending > 0)
+            render_send_frame(o);
+    }
+}
+
+// close the part being written, save where the render got to and start the
+// next part
+static void render_next_part()
+{
+    render_flush();
+    bool ok = render_encoding();
+    for (size_t i = 0; i < p->output_count; ++i) {
+        Render_Output *o = &p->outputs[i];
+        if (o->encoder != NULL && !encoder_stop(o->encoder, NULL))
+            ok = false;
+        o->encoder = NULL;
+    }
+    if (!ok)
+        return;
+
+    p->render_part += 1;
+    p->render_part_first = p->render_frame_index;
+    render_checkpoint_save();
+    // NOTE: the new encoders have no frame to repeat
+    p->render_hashed = false;
+    for (size_t i = 0; i < p->output_count; ++i) {
+        if (!render_output_encode(&p->outputs[i], NULL))
+            return;
+    }
+}
+
+// end the encoders; a checkpointed render joins its parts once it's done and
+// keeps them along with a checkpoint to resume from otherwise
+static bool render_finish(Render_Stats *stats)
+{
+    render_flush();
+    bool done = render_done();
+    bool ok = render_end_encodings(stats);
+    if (!ok || p->render_checkpoint == 0)
+        return ok;
+    if (stats != NULL)
+        stats->frames = p->render_frame_index - p->render_first_frame;
+
+    // NOTE: a render stopped right after a checkpoint has an empty last part
+    if (p->render_frame_index > p->render_part_first)
+        p->render_part += 1;
+    if (!done) {
+        p->render_part_first = p->render_frame_index;
+        render_checkpoint_save();
+        TraceLog(LOG_WARNING, "RENDER: stopped at frame %zu, rendering %s "
+                              "again resumes from there",
+                 p->render_frame_index, p->render_profile.name);
+        return true;
+    }
+
+    for (size_t i = 0; i < p->output_count; ++i)
+        ok = segments_join(&p->outputs[i].profile, p->render_part,
+                           &p->render_audio) &&
+             ok;
+    if (ok)
+        checkpoint_remove(render_checkpoint_path());
+    return ok;
+}
+
+// fade the smoothing state into the one the loop starts with so its last frame
+// leads into its first one like any two frames do
+static void render_loop_crossfade(size_t m)
+{
+    if (p->render_frame_index >= p->render_loop_last)
+        return;
+    size_t left = p->render_loop_last - p->render_frame_index;
+    if (left > p->render_loop_fade)
+        return;
+
+    float t = 1.0f - (float)(left - 1) / p->render_loop_fade;
+    for (size_t i = 0; i < m; ++i) {
+        p->out_smooth[i] += (p->loop_smooth[i] - p->out_smooth[i]) * t;
+        p->out_smear[i] += (p->loop_smear[i] - p->out_smear[i]) * t;
+    }
+}
+
+// count the silent samples at the end of the analysis window after `chunk`
+// was pushed into it
+static void render_track_silence(const float *chunk, size_t count)
+{
+    size_t zeros = 0;
+    while (zeros < count && chunk[count - 1 - zeros] == 0.0f)
+        zeros += 1;
+    if (zeros == count) {
+        p->render_silence += count;
+    } else {
+        p->render_silence = zeros;
+    }
+}
+
+// a cheap hash of what a frame shows: the values that are drawn, quantized
+// (FNV-1a)
+static uint64_t render_frame_hash(size_t m)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < m; ++i) {
+        int32_t smooth = p->out_smooth[i] * RENDER_STATIC_QUANTUM;
+        int32_t smear = p->out_smear[i] * RENDER_STATIC_QUANTUM;
+        hash = (hash ^ (uint32_t)smooth) * 1099511628211ULL;
+        hash = (hash ^ (uint32_t)smear) * 1099511628211ULL;
+    }
+    return (hash ^ m) * 1099511628211ULL;
+}
+
+// draw the analysis of `m` bins into `o` and send it to its encoder
+static void render_output_frame(Render_Output *o, size_t m, double *t)
+{
+    if (o->softrender != NULL) {
+        void *frame = encoder_acquire(o->encoder);
+        render_stage_end(RENDER_STAGE_ENCODER, t);
+        if (frame == NULL) {
+            render_end_encoding(o, NULL);
+            return;
+        }
+        softrender_frame(o->softrender, p->out_smooth, p->out_smear, m,
+                         COLOR_BACKGROUND, frame);
+        encoder_submit(o->encoder);
+        render_stage_end(RENDER_STAGE_DRAW, t);
+        return;
+    }
+
+    begin_flipped_texture_mode(o->screen);
+    ClearBackground(COLOR_BACKGROUND);
+    Rectangle boundary = {0, 0, o->screen.texture.width,
+                          o->screen.texture.height};
+    float circle_scale = o->profile.bloom ? BLOOM_CORE_SCALE : 1.0f;
+    if (!o->profile.single_pass ||
+        !bands_draw_visualizer(&p->bands, boundary, p->out_smooth,
+                               p->out_smear, m, circle_scale))
+        fft_render(boundary, m, circle_scale);
+    end_flipped_texture_mode();
+
+    if (o->profile.bloom) {
+        bloom_blur(&o->bloom, &p->bloom, o->screen);
+        begin_flipped_texture_mode(o->screen);
+        bloom_composite(&o->bloom, boundary);
+        end_flipped_texture_mode();
+    }
+
+    unsigned int fbo = o->screen.id;
+    if (o->packed_yuv) {
+        render_yuv420(o);
+        fbo = o->yuv.id;
+    }
+    // NOTE: the GPU works asynchronously, what isn't done by now shows up in
+    //       the readback of the frame
+    render_stage_end(RENDER_STAGE_DRAW, t);
+
+    if (readback_full(&o->readback))
+        render_send_frame(o);
+    *t = clock_now();
+    if (o->encoder != NULL)
+        readback_push(&o->readback, fbo);
+    render_stage_end(RENDER_STAGE_READBACK, t);
+}
+
+// the analysis of the frame at `wave_cursor`, returns the count of bands
+static size_t render_analyze(size_t fps, double *t)
+{
+    float dt = 1.0f / fps;
+    if (p->spectrum.map != NULL) {
+        size_t m = render_spectrum_read(fps);
+        fft_smooth(m, dt);
+        return m;
+    }
+
+    size_t chunk_size = render_chunk_size(fps);
+    float *chunk = fft_push_many(chunk_size);
+    render_source_read(chunk, chunk_size);
+    if (t != NULL)
+        render_stage_end(RENDER_STAGE_DECODE, t);
+    render_track_silence(chunk, chunk_size);
+
+    // NOTE: a silent window squashes into zeros, only the smoothing moves
+    size_t m = p->render_bins;
+    if (p->render_silence >= N && m > 0) {
+        memset(p->out_log, 0, m * sizeof(p->out_log[0]));
+        fft_smooth(m, dt);
+    } else {
+        m = fft_analyze(dt);
+        p->render_bins = m;
+    }
+    return m;
+}
+
+// one video frame: analysis, drawing, readback and encoding
+// NOTE: the frame drawn now is sent `RENDER_READBACK_RING - 1` frames later
+//       so the GPU, the readback and the encoder can overlap
+static void render_frame()
+{
+    if (p->render_checkpoint > 0 &&
+        p->render_frame_index - p->render_part_first >= p->render_checkpoint) {
+        render_next_part();
+        if (!render_encoding())
+            return;
+    }
+
+    size_t fps = p->render_profile.fps;
+    double t = clock_now();
+    size_t m = render_analyze(fps, &t);
+    if (p->render_loop_fade > 0)
+        render_loop_crossfade(m);
+    p->render_frame_index += 1;
+
+    // NOTE: silent passages and the end of the fade out look the same from
+    //       one frame to the next; such a frame is not drawn nor read back,
+    //       the encoder sends the previous one again once the frames still
+    //       in the readback ring are out
+    uint64_t hash = render_frame_hash(m);
+    render_stage_end(RENDER_STAGE_ANALYSIS, &t);
+    if (p->render_hashed && hash == p->render_hash) {
+        render_flush();
+        for (size_t i = 0; i < p->output_count; ++i) {
+            if (p->outputs[i].encoder != NULL)
+                encoder_repeat(p->outputs[i].encoder);
+        }
+        render_stages_next_frame();
+        return;
+    }
+    p->render_hashed = true;
+    p->render_hash = hash;
+
+    for (size_t i = 0; i < p->output_count; ++i)
+        render_output_frame(&p->outputs[i], m, &t);
+    render_stages_next_frame();
 }
 
 static void error_load_file_popup()
@@ -434,13 +1808,122 @@ static void error_load_file_popup()
     TraceLog(LOG_ERROR, "Could not load file");
 }
 
+static void draw_text(const char *text, Vector2 position, float font_size,
+                      Color color)
+{
+    if (p->font_sdf)
+        BeginShaderMode(p->sdf);
+    DrawTextEx(p->font, text, position, font_size, 0, color);
+    if (p->font_sdf)
+        EndShaderMode();
+}
+
+// the name of `track` at `font_size`, cut with an ellipsis if it's wider than
+// `width`; `size` is the one measured
+static const char *track_label(Track *track, float font_size, float width,
+                               Vector2 *size)
+{
+    if (track->label != NULL && track->label_font_size == font_size &&
+        track->label_width == width) {
+        *size = track->label_size;
+        return track->label;
+    }
+
+    const char *name = GetFileName(track->file_path);
+    size_t len = strlen(name);
+    Vector2 measured = MeasureTextEx(p->font, name, font_size, 0);
+    size_t kept = len;
+    if (measured.x > width) {
+        // the longest start of the name that fits along with the ellipsis
+        size_t lo = 0;
+        size_t hi = len;
+        while (lo < hi) {
+            size_t mid = (lo + hi + 1) / 2;
+            const char *cut = TextFormat("%.*s...", (int)mid, name);
+            if (MeasureTextEx(p->font, cut, font_size, 0).x <= width) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        kept = lo;
+        // NOTE: not in the middle of an UTF-8 sequence
+        while (kept > 0 && ((unsigned char)name[kept] & 0xC0) == 0x80)
+            kept -= 1;
+    }
+
+    free(track->label);
+    track->label = strdup(kept < len ? TextFormat("%.*s...", (int)kept, name)
+                                     : name);
+    assert(track->label != NULL && "Buy more RAM!!");
+    track->label_font_size = font_size;
+    track->label_width = width;
+    track->label_size = kept < len
+                            ? MeasureTextEx(p->font, track->label, font_size, 0)
+                            : measured;
+    *size = track->label_size;
+    return track->label;
+}
+
+// the state of the UI a layer shows: the layer is drawn again when it changes
+static uint64_t ui_key(const void *state, size_t size)
+{
+    const unsigned char *bytes = state;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    return hash;
+}
+
+// true if `layer` must be drawn again for `key`: what's drawn until
+// ui_layer_end() goes into its texture, at the coordinates of the screen
+static bool ui_layer_begin(Ui_Layer *layer, Rectangle boundary, uint64_t key)
+{
+    int width = ceilf(boundary.width);
+    int height = ceilf(boundary.height);
+    if (width <= 0 || height <= 0)
+        return false;
+    if (layer->target.texture.width != width ||
+        layer->target.texture.height != height) {
+        UnloadRenderTexture(layer->target);
+        layer->target = LoadRenderTexture(width, height);
+        layer->valid = false;
+    }
+    if (layer->valid && layer->key == key)
+        return false;
+    layer->key = key;
+    layer->valid = true;
+
+    BeginTextureMode(layer->target);
+    ClearBackground(BLANK);
+    rlTranslatef(-boundary.x, -boundary.y, 0);
+    begin_premultiplied_blend_mode();
+    return true;
+}
+
+static void ui_layer_end()
+{
+    EndBlendMode();
+    EndTextureMode();
+}
+
+static void ui_layer_draw(const Ui_Layer *layer, Rectangle boundary)
+{
+    if (!layer->valid)
+        return;
+    Texture2D texture = layer->target.texture;
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(texture,
+                   CLITERAL(Rectangle){0, 0, texture.width, -texture.height},
+                   CLITERAL(Vector2){boundary.x, boundary.y}, WHITE);
+    EndBlendMode();
+}
+
 // if Apple Retina, ensure FLAG_WINDOW_HIGHDPI is set before
 // InitWindow()
 // FIXME: 2023-11-14 still an issue with raylib 5.0 dev
 static void timeline(Rectangle timeline_boundary, Track *track)
 {
-    DrawRectangleRec(timeline_boundary, COLOR_TIMELINE_BACKGROUND);
-
     float played = GetMusicTimePlayed(track->music);
     float len = GetMusicTimeLength(track->music);
 #ifdef __APPLE__
@@ -448,6 +1931,43 @@ static void timeline(Rectangle timeline_boundary, Track *track)
 #else
     int w = GetRenderWidth();
 #endif
+
+    // NOTE: only the cursor moves while the track plays, the rest is a layer
+    struct {
+        Rectangle boundary;
+        float len;
+        float region_in;
+        float region_out;
+        bool loop;
+        int w;
+    } state;
+    memset(&state, 0, sizeof(state));
+    state.boundary = timeline_boundary;
+    state.len = len;
+    state.region_in = track->region_in;
+    state.region_out = track->region_out;
+    state.loop = track->loop;
+    state.w = w;
+    if (ui_layer_begin(&p->ui_timeline, timeline_boundary,
+                       ui_key(&state, sizeof(state)))) {
+        DrawRectangleRec(timeline_boundary, COLOR_TIMELINE_BACKGROUND);
+
+        // the region to render
+        if (track->region_in > 0 || track->region_out > 0 || track->loop) {
+            float out = track->region_out > 0 ? track->region_out : len;
+            Rectangle region = {
+                .x = track->region_in / len * w,
+                .y = timeline_boundary.y,
+                .width = (out - track->region_in) / len * w,
+                .height = timeline_boundary.height,
+            };
+            DrawRectangleRec(region, track->loop ? COLOR_TIMELINE_LOOP
+                                                 : COLOR_TIMELINE_REGION);
+        }
+        ui_layer_end();
+    }
+    ui_layer_draw(&p->ui_timeline, timeline_boundary);
+
     float x = played / len * w;
     Vector2 startPos = {
         .x = x,
@@ -467,15 +1987,38 @@ static void timeline(Rectangle timeline_boundary, Track *track)
         }
     }
 
-    // TODO: enable the user to render a specific region instead of the whole
-    // song.
     // TODO: visualize sound wave on the timeline
 }
 
-static void tracks_panel(Rectangle panel_boundary)
+// the button of the `i`th track of the panel scrolled by `scroll`
+static Rectangle tracks_panel_item(Rectangle panel_boundary, size_t i,
+                                   float scroll)
+{
+    float scroll_bar_width = panel_boundary.width * 0.03;
+    // TODO: don't scale item_size relative to the panel width
+    float item_size = panel_boundary.width * 0.2;
+    float panel_padding = item_size * 0.1;
+    return CLITERAL(Rectangle){
+        .x = panel_boundary.x + panel_padding,
+        .y = i * item_size + panel_boundary.y + panel_padding - scroll,
+        .width = panel_boundary.width - panel_padding * 2 - scroll_bar_width,
+        .height = item_size - panel_padding * 2,
+    };
+}
+
+// the time of the last frame for what animates the UI
+// NOTE: the first frame after waiting for events (see plug_idle()) comes
+//       after the whole wait, which is no time to scroll or fade out for
+static float ui_frame_time()
 {
-    DrawRectangleRec(panel_boundary, COLOR_TRACK_PANEL_BACKGROUND);
+    float dt = GetFrameTime();
+    if (dt > 1.0f / IDLE_SETTLING_FPS)
+        dt = 1.0f / IDLE_SETTLING_FPS;
+    return dt;
+}
 
+static void tracks_panel(Rectangle panel_boundary)
+{
     Vector2 mouse = GetMousePosition();
 
     float scroll_bar_width = panel_boundary.width * 0.03;
@@ -490,7 +2033,7 @@ static void tracks_panel(Rectangle panel_boundary)
     if (CheckCollisionPointRec(mouse, panel_boundary)) {
         panel_velocity += GetMouseWheelMove() * item_size * 8;
     }
-    panel_scroll -= panel_velocity * GetFrameTime();
+    panel_scroll -= panel_velocity * ui_frame_time();
 
     static bool scrolling = false;
     static float scrolling_mouse_offset = 0.0f;
@@ -507,68 +2050,44 @@ static void tracks_panel(Rectangle panel_boundary)
         max_scroll = 0;
     if (panel_scroll > max_scroll)
         panel_scroll = max_scroll;
-    float panel_padding = item_size * 0.1;
-
-    BeginScissorMode(panel_boundary.x, panel_boundary.y, panel_boundary.width,
-                     panel_boundary.height);
+    // NOTE: the panel is drawn again when it scrolls by a whole pixel, not
+    //       while the scrolling slows down to a stop
+    float scroll = roundf(panel_scroll);
 
-    for (size_t i = 0; i < p->tracks.count; ++i) {
-        // TODO: tooltip with filepath on each item in the panel
-        Rectangle item_boundary = {
-            .x = panel_boundary.x + panel_padding,
-            .y =
-                i * item_size + panel_boundary.y + panel_padding - panel_scroll,
-            .width =
-                panel_boundary.width - panel_padding * 2 - scroll_bar_width,
-            .height = item_size - panel_padding * 2,
-        };
-        Color color;
-        if ((int)i != p->current_track) {
-            if (CheckCollisionPointRec(mouse, panel_boundary) &&
-                CheckCollisionPointRec(mouse, item_boundary)) {
-                color = COLOR_TRACK_BUTTON_HOVEROVER;
-                if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
-                    Track *track = current_track();
-                    if (track)
-                        StopMusicStream(track->music);
-                    PlayMusicStream(p->tracks.items[i].music);
-                    p->current_track = i;
-                }
-            } else {
-                color = COLOR_TRACK_BUTTON_BACKGROUND;
+    // TODO: tooltip with filepath on each item in the panel
+    int hovered = -1;
+    if (CheckCollisionPointRec(mouse, panel_boundary)) {
+        for (size_t i = 0; i < p->tracks.count; ++i) {
+            Rectangle item_boundary =
+                tracks_panel_item(panel_boundary, i, scroll);
+            if (CheckCollisionPointRec(mouse, item_boundary)) {
+                hovered = i;
+                break;
             }
-        } else {
-            color = COLOR_TRACK_BUTTON_SELECTED;
         }
-        // TODO: enable MSAA so the rounded rectangles look better
-        DrawRectangleRounded(item_boundary, 0.2, 20, color);
-
-        const char *text = GetFileName(p->tracks.items[i].file_path);
-        float fontSize = item_boundary.height * 0.5;
-        float text_padding = item_boundary.width * 0.05;
-        Vector2 size = MeasureTextEx(p->font, text, fontSize, 0);
-        Vector2 position = {
-            .x = item_boundary.x + text_padding,
-            .y = item_boundary.y + item_boundary.height * 0.5 - size.y * 0.5,
-        };
-        // TODO: cut out overflown text
-        // TODO: use SDF fonts
-        DrawTextEx(p->font, text, position, fontSize, 0, WHITE);
+    }
+    if (hovered >= 0 && hovered != p->current_track &&
+        IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
+        Track *track = current_track();
+        if (track)
+            StopMusicStream(track->music);
+        PlayMusicStream(p->tracks.items[hovered].music);
+        p->current_track = hovered;
     }
 
     // TODO: jump to specific place by clicking the scrollbar
     // TODO: up and down clickable buttons on the scrollbar
-    if (entire_scrollable_area > visible_area_size) {
+    bool scroll_bar = entire_scrollable_area > visible_area_size;
+    Rectangle scroll_bar_boundary = {0};
+    if (scroll_bar) {
         float t = visible_area_size / entire_scrollable_area;
-        float q = panel_scroll / entire_scrollable_area;
-        Rectangle scroll_bar_boundary = {
+        float q = scroll / entire_scrollable_area;
+        scroll_bar_boundary = CLITERAL(Rectangle){
             .x = panel_boundary.x + panel_boundary.width - scroll_bar_width,
             .y = panel_boundary.y + panel_boundary.height * q,
             .width = scroll_bar_width,
             .height = panel_boundary.height * t,
         };
-        DrawRectangleRounded(scroll_bar_boundary, 0.8, 20,
-                             COLOR_TRACK_BUTTON_BACKGROUND);
 
         if (scrolling) {
             if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
@@ -584,7 +2103,64 @@ static void tracks_panel(Rectangle panel_boundary)
         }
     }
 
-    EndScissorMode();
+    struct {
+        Rectangle boundary;
+        float scroll;
+        size_t count;
+        int current;
+        int hovered;
+    } state;
+    memset(&state, 0, sizeof(state));
+    state.boundary = panel_boundary;
+    state.scroll = scroll;
+    state.count = p->tracks.count;
+    state.current = p->current_track;
+    state.hovered = hovered;
+    // NOTE: the texture of the layer cuts out what's outside of the panel
+    if (ui_layer_begin(&p->ui_tracks, panel_boundary,
+                       ui_key(&state, sizeof(state)))) {
+        DrawRectangleRec(panel_boundary, COLOR_TRACK_PANEL_BACKGROUND);
+
+        for (size_t i = 0; i < p->tracks.count; ++i) {
+            Rectangle item_boundary =
+                tracks_panel_item(panel_boundary, i, scroll);
+            // NOTE: only the tracks in sight, however long the list
+            if (item_boundary.y + item_boundary.height < panel_boundary.y)
+                continue;
+            if (item_boundary.y > panel_boundary.y + panel_boundary.height)
+                break;
+            Color color;
+            if ((int)i == p->current_track) {
+                color = COLOR_TRACK_BUTTON_SELECTED;
+            } else if ((int)i == hovered) {
+                color = COLOR_TRACK_BUTTON_HOVEROVER;
+            } else {
+                color = COLOR_TRACK_BUTTON_BACKGROUND;
+            }
+            // TODO: enable MSAA so the rounded rectangles look better
+            DrawRectangleRounded(item_boundary, 0.2, 20, color);
+
+            float fontSize = item_boundary.height * 0.5;
+            float text_padding = item_boundary.width * 0.05;
+            Vector2 size;
+            const char *text =
+                track_label(&p->tracks.items[i], fontSize,
+                            item_boundary.width - text_padding * 2, &size);
+            Vector2 position = {
+                .x = item_boundary.x + text_padding,
+                .y = item_boundary.y + item_boundary.height * 0.5 -
+                     size.y * 0.5,
+            };
+            draw_text(text, position, fontSize, WHITE);
+        }
+
+        if (scroll_bar) {
+            DrawRectangleRounded(scroll_bar_boundary, 0.8, 20,
+                                 COLOR_TRACK_BUTTON_BACKGROUND);
+        }
+        ui_layer_end();
+    }
+    ui_layer_draw(&p->ui_tracks, panel_boundary);
 }
 
 typedef enum {
@@ -608,36 +2184,51 @@ static int fullscreen_button(Rectangle preview_boundary)
     int hoverover = CheckCollisionPointRec(mouse, fullscreen_button_boundary);
     int clicked = hoverover && IsMouseButtonReleased(MOUSE_BUTTON_LEFT);
 
-    Color color =
-        hoverover ? COLOR_HUD_BUTTON_HOVEROVER : COLOR_HUD_BUTTON_BACKGROUND;
-
-    DrawRectangleRounded(fullscreen_button_boundary, 0.5, 20, color);
-    float icon_size = 512;
-    float scale = HUD_BUTTON_SIZE / icon_size * HUD_ICON_SCALE;
-    Rectangle dest = {
-        fullscreen_button_boundary.x + fullscreen_button_boundary.width / 2 -
-            icon_size * scale / 2,
-        fullscreen_button_boundary.y + fullscreen_button_boundary.height / 2 -
-            icon_size * scale / 2,
-        icon_size * scale, icon_size * scale};
-    size_t icon_index;
-    if (!p->fullscreen) {
-        if (!hoverover) {
-            icon_index = 0;
-        } else {
-            icon_index = 1;
-        }
-    } else {
-        if (!hoverover) {
-            icon_index = 2;
+    struct {
+        Rectangle boundary;
+        int hoverover;
+        bool fullscreen;
+    } state;
+    memset(&state, 0, sizeof(state));
+    state.boundary = fullscreen_button_boundary;
+    state.hoverover = hoverover;
+    state.fullscreen = p->fullscreen;
+    if (ui_layer_begin(&p->ui_fullscreen, fullscreen_button_boundary,
+                       ui_key(&state, sizeof(state)))) {
+        Color color = hoverover ? COLOR_HUD_BUTTON_HOVEROVER
+                                : COLOR_HUD_BUTTON_BACKGROUND;
+
+        DrawRectangleRounded(fullscreen_button_boundary, 0.5, 20, color);
+        float icon_size = 512;
+        float scale = HUD_BUTTON_SIZE / icon_size * HUD_ICON_SCALE;
+        Rectangle dest = {fullscreen_button_boundary.x +
+                              fullscreen_button_boundary.width / 2 -
+                              icon_size * scale / 2,
+                          fullscreen_button_boundary.y +
+                              fullscreen_button_boundary.height / 2 -
+                              icon_size * scale / 2,
+                          icon_size * scale, icon_size * scale};
+        size_t icon_index;
+        if (!p->fullscreen) {
+            if (!hoverover) {
+                icon_index = 0;
+            } else {
+                icon_index = 1;
+            }
         } else {
-            icon_index = 3;
+            if (!hoverover) {
+                icon_index = 2;
+            } else {
+                icon_index = 3;
+            }
         }
+        Rectangle source = {icon_size * icon_index, 0, icon_size, icon_size};
+        DrawTexturePro(assets_texture("./resources/icons/fullscreen.png"),
+                       source, dest, CLITERAL(Vector2){0}, 0,
+                       ColorBrightness(WHITE, -0.10));
+        ui_layer_end();
     }
-    Rectangle source = {icon_size * icon_index, 0, icon_size, icon_size};
-    DrawTexturePro(assets_texture("./resources/icons/fullscreen.png"), source,
-                   dest, CLITERAL(Vector2){0}, 0,
-                   ColorBrightness(WHITE, -0.10));
+    ui_layer_draw(&p->ui_fullscreen, fullscreen_button_boundary);
 
     return (clicked << 1) | hoverover;
 }
@@ -653,40 +2244,58 @@ static float slider_get_value(float x, float lo_x, float hi_x)
     return x;
 }
 
-static void horz_slider(Rectangle boundary, float *value, bool *dragging)
+// the ends of the line of a slider
+static void horz_slider_ends(Rectangle boundary, Vector2 *startPos,
+                             Vector2 *endPos)
 {
-    Vector2 mouse = GetMousePosition();
-
-    Vector2 startPos = {
+    *startPos = CLITERAL(Vector2){
         .x = boundary.x + boundary.height / 2,
         .y = boundary.y + boundary.height / 2,
     };
-    Vector2 endPos = {
+    *endPos = CLITERAL(Vector2){
         .x = boundary.x + boundary.width - boundary.height / 2,
         .y = boundary.y + boundary.height / 2,
     };
+}
+
+static void horz_slider_draw(Rectangle boundary, float value)
+{
+    Vector2 startPos, endPos;
+    horz_slider_ends(boundary, &startPos, &endPos);
     Color color = WHITE;
     DrawLineEx(startPos, endPos, boundary.height * 0.10, color);
+    Vector2 center = {
+        .x = startPos.x + (endPos.x - startPos.x) * value,
+        .y = startPos.y,
+    };
+    float radius = boundary.height / 4;
+    Texture2D texture = {rlGetTextureIdDefault(), 1, 1, 1,
+                         PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    SetShaderValue(p->circle, p->circle_radius_location, (float[1]){0.43f},
+                   SHADER_UNIFORM_FLOAT);
+    SetShaderValue(p->circle, p->circle_power_location, (float[1]){2.0f},
+                   SHADER_UNIFORM_FLOAT);
+    BeginShaderMode(p->circle);
+    Rectangle source = {0, 0, 1, 1};
+    Rectangle dest = {center.x - radius, center.y - radius, radius * 2,
+                      radius * 2};
+    Vector2 origin = {0};
+    DrawTexturePro(texture, source, dest, origin, 0, color);
+    EndShaderMode();
+}
+
+// the input of a slider, drawn by horz_slider_draw()
+static void horz_slider(Rectangle boundary, float *value, bool *dragging)
+{
+    Vector2 mouse = GetMousePosition();
+
+    Vector2 startPos, endPos;
+    horz_slider_ends(boundary, &startPos, &endPos);
     Vector2 center = {
         .x = startPos.x + (endPos.x - startPos.x) * (*value),
         .y = startPos.y,
     };
     float radius = boundary.height / 4;
-    {
-        Texture2D texture = {rlGetTextureIdDefault(), 1, 1, 1,
-                             PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
-        SetShaderValue(p->circle, p->circle_radius_location, (float[1]){0.43f},
-                       SHADER_UNIFORM_FLOAT);
-        SetShaderValue(p->circle, p->circle_power_location, (float[1]){2.0f},
-                       SHADER_UNIFORM_FLOAT);
-        BeginShaderMode(p->circle);
-        Rectangle source = {0, 0, 1, 1};
-        Rectangle dest = {center.x - radius, center.y - radius, radius * 2,
-                          radius * 2};
-        Vector2 origin = {0};
-        DrawTexturePro(texture, source, dest, origin, 0, color);
-        EndShaderMode();
-    }
 
     if (!*dragging) {
         if (CheckCollisionPointCircle(mouse, center, radius)) {
@@ -732,47 +2341,17 @@ static void volume_slider(Rectangle preview_boundary)
     expanded =
         dragging || CheckCollisionPointRec(mouse, volume_slider_boundary);
 
-    Color color = COLOR_HUD_BUTTON_HOVEROVER;
-    DrawRectangleRounded(volume_slider_boundary, 0.5, 20, color);
-
-    float icon_size = 512;
-    float scale = HUD_BUTTON_SIZE / icon_size * HUD_ICON_SCALE;
-    Rectangle dest = {volume_slider_boundary.x + (float)HUD_BUTTON_SIZE / 2 -
-                          icon_size * scale / 2,
-                      volume_slider_boundary.y + (float)HUD_BUTTON_SIZE / 2 -
-                          icon_size * scale / 2,
-                      icon_size * scale, icon_size * scale};
-
     // TODO: animate volume slider expansion
     float volume = GetMasterVolume();
 
-    size_t icon_index;
-    if (volume <= 0) {
-        icon_index = 0;
-    } else {
-        size_t phases = 2;
-        icon_index = volume * phases;
-
-        if (icon_index >= phases)
-            icon_index = phases - 1;
-        ;
-        icon_index += 1;
-    }
-
-    Rectangle source = {icon_size * icon_index, 0, icon_size, icon_size};
-
-    DrawTexturePro(assets_texture("./resources/icons/volume.png"), source, dest,
-                   CLITERAL(Vector2){0}, 0, ColorBrightness(WHITE, -0.10));
-
+    Rectangle slider_boundary = {
+        .x = volume_slider_boundary.x + HUD_BUTTON_SIZE,
+        .y = volume_slider_boundary.y,
+        .width = (expanded_slots - 1) * HUD_BUTTON_SIZE,
+        .height = HUD_BUTTON_SIZE,
+    };
     if (expanded) {
-        horz_slider(
-            CLITERAL(Rectangle){
-                .x = volume_slider_boundary.x + HUD_BUTTON_SIZE,
-                .y = volume_slider_boundary.y,
-                .width = (expanded_slots - 1) * HUD_BUTTON_SIZE,
-                .height = HUD_BUTTON_SIZE,
-            },
-            &volume, &dragging);
+        horz_slider(slider_boundary, &volume, &dragging);
         float mouse_wheel_step = 0.05;
         volume += GetMouseWheelMove() * mouse_wheel_step;
         if (volume < 0)
@@ -793,6 +2372,54 @@ static void volume_slider(Rectangle preview_boundary)
             SetMasterVolume(volume);
         }
     }
+
+    struct {
+        Rectangle boundary;
+        float volume;
+        int expanded;
+    } state;
+    memset(&state, 0, sizeof(state));
+    state.boundary = volume_slider_boundary;
+    state.volume = volume;
+    state.expanded = expanded;
+    if (ui_layer_begin(&p->ui_volume, volume_slider_boundary,
+                       ui_key(&state, sizeof(state)))) {
+        Color color = COLOR_HUD_BUTTON_HOVEROVER;
+        DrawRectangleRounded(volume_slider_boundary, 0.5, 20, color);
+
+        float icon_size = 512;
+        float scale = HUD_BUTTON_SIZE / icon_size * HUD_ICON_SCALE;
+        Rectangle dest = {volume_slider_boundary.x +
+                              (float)HUD_BUTTON_SIZE / 2 -
+                              icon_size * scale / 2,
+                          volume_slider_boundary.y +
+                              (float)HUD_BUTTON_SIZE / 2 -
+                              icon_size * scale / 2,
+                          icon_size * scale, icon_size * scale};
+
+        size_t icon_index;
+        if (volume <= 0) {
+            icon_index = 0;
+        } else {
+            size_t phases = 2;
+            icon_index = volume * phases;
+
+            if (icon_index >= phases)
+                icon_index = phases - 1;
+            icon_index += 1;
+        }
+
+        Rectangle source = {icon_size * icon_index, 0, icon_size, icon_size};
+
+        DrawTexturePro(assets_texture("./resources/icons/volume.png"), source,
+                       dest, CLITERAL(Vector2){0}, 0,
+                       ColorBrightness(WHITE, -0.10));
+
+        if (expanded)
+            horz_slider_draw(slider_boundary, volume);
+        ui_layer_end();
+    }
+    ui_layer_draw(&p->ui_volume, volume_slider_boundary);
 }
 
 static void preview_screen()
@@ -885,18 +2512,31 @@ static void preview_screen()
         }
 
         if (IsKeyPressed(KEY_R)) {
-            StopMusicStream(track->music);
+            render_start(track);
+        }
 
-            fft_clean();
-            // TODO: LoadWave is pretty slow on big files
-            p->wave = LoadWave(track->file_path);
-            p->wave_cursor = 0;
-            p->wave_samples = LoadWaveSamples(p->wave);
-            p->ffmpeg = ffmpeg_start_rendering(p->screen.texture.width,
-                                               p->screen.texture.height,
-                                               RENDER_FPS, track->file_path);
-            p->rendering = true;
-            SetTraceLogLevel(LOG_WARNING);
+        if (IsKeyPressed(KEY_P)) {
+            render_profile_next();
+        }
+
+        // in and out points of the region to render, loop over it, clear it
+        if (IsKeyPressed(KEY_I)) {
+            track->region_in = GetMusicTimePlayed(track->music);
+            if (track->region_out <= track->region_in)
+                track->region_out = 0;
+        }
+        if (IsKeyPressed(KEY_O)) {
+            track->region_out = GetMusicTimePlayed(track->music);
+            if (track->region_out <= track->region_in)
+                track->region_in = 0;
+        }
+        if (IsKeyPressed(KEY_L)) {
+            track->loop = !track->loop;
+        }
+        if (IsKeyPressed(KEY_X)) {
+            track->region_in = 0;
+            track->region_out = 0;
+            track->loop = false;
         }
 
         if (IsKeyPressed(KEY_F)) {
@@ -907,7 +2547,11 @@ static void preview_screen()
         // TODO: add tooltips to all the buttons that describe their
         // function and associated keyboard shortcuts
 
-        size_t m = fft_analyze(GetFrameTime());
+        size_t m = fft_analyze_preview(GetFrameTime());
+        // NOTE: a paused track leaves the last window of samples behind, the
+        //       bands stop on it
+        p->fft_still =
+            !IsMusicStreamPlaying(track->music) && fft_at_rest(m);
 
         if (p->fullscreen) {
             Rectangle preview_boundary = {
@@ -916,7 +2560,7 @@ static void preview_screen()
                 .width = w,
                 .height = h,
             };
-            fft_render(preview_boundary, m);
+            fft_render_preview(preview_boundary, m);
 
             static float hud_timer = HUD_TIMER_SECS;
             if (hud_timer > 0.0) {
@@ -924,7 +2568,7 @@ static void preview_screen()
                 if (state & BS_CLICKED)
                     p->fullscreen = !p->fullscreen;
                 if (!(state & BS_HOVEROVER))
-                    hud_timer -= GetFrameTime();
+                    hud_timer -= ui_frame_time();
                 // TODO: the state of volume slider does not reset
                 // hud_timer
 
@@ -943,10 +2587,7 @@ static void preview_screen()
                                           .width = w - tracks_panel_width,
                                           .height = h - timeline_height};
 
-            BeginScissorMode(preview_boundary.x, preview_boundary.y,
-                             preview_boundary.width, preview_boundary.height);
-            fft_render(preview_boundary, m);
-            EndScissorMode();
+            fft_render_preview(preview_boundary, m);
 
             tracks_panel(CLITERAL(Rectangle){
                 .x = 0,
@@ -979,7 +2620,7 @@ static void preview_screen()
             (float)w / 2 - size.x / 2,
             (float)h / 2 - size.y / 2,
         };
-        DrawTextEx(p->font, label, position, p->font.baseSize, 0, color);
+        draw_text(label, position, p->font.baseSize, color);
     }
 }
 
@@ -1001,8 +2642,8 @@ static void capture_screen()
             p->capturing = false;
         }
 
-        size_t m = fft_analyze(GetFrameTime());
-        fft_render(CLITERAL(Rectangle){0, 0, w, h}, m);
+        size_t m = fft_analyze_preview(GetFrameTime());
+        fft_render_preview(CLITERAL(Rectangle){0, 0, w, h}, m);
     } else {
         if (IsKeyPressed(KEY_ESCAPE)) {
             p->capturing = false;
@@ -1016,18 +2657,152 @@ static void capture_screen()
             (float)w / 2 - size.x / 2,
             (float)h / 2 - size.y / 2,
         };
-        DrawTextEx(p->font, label, position, fontSize, 0, color);
+        draw_text(label, position, fontSize, color);
 
         label = "(Press ESC to continue)";
         fontSize = p->font.baseSize * 2 / 3;
         size = MeasureTextEx(p->font, label, fontSize, 0);
         position.x = (float)w / 2 - size.x / 2;
         position.x = (float)w / 2 - size.x / 2;
-        DrawTextEx(p->font, label, position, fontSize, 0, color);
+        draw_text(label, position, fontSize, color);
     }
 }
 #endif // FEATURE_MICROPHONE
 
+static void rendering_failure(int w, int h)
+{
+    const char *label = "FFmpeg Failure: Check the Logs";
+    Color color = RED;
+    int fontSize = p->font.baseSize;
+    Vector2 size = MeasureTextEx(p->font, label, fontSize, 0);
+    Vector2 position = {
+        (float)w / 2 - size.x / 2,
+        (float)h / 2 - size.y / 2,
+    };
+    draw_text(label, position, fontSize, color);
+
+    label = "(Press ESC to Continue)";
+    fontSize = p->font.baseSize * 2 / 3;
+    size = MeasureTextEx(p->font, label, fontSize, 0);
+    position.x = (float)w / 2 - size.x / 2;
+    position.y = (float)h / 2 - size.y / 2 + fontSize;
+    draw_text(label, position, fontSize, color);
+}
+
+static void rendering_progress(int w, int h, const char *label,
+                               float bar_progress)
+{
+    // label
+    Color color = WHITE;
+
+    Vector2 size = MeasureTextEx(p->font, label, p->font.baseSize, 0);
+    Vector2 position = {
+        (float)w / 2 - size.x / 2,
+        (float)h / 2 - size.y / 2,
+    };
+    draw_text(label, position, p->font.baseSize, color);
+
+    // progress bar
+    float bar_width = (float)w * 2 / 3;
+    float bar_height = p->font.baseSize * 0.25;
+    float bar_padding_top = p->font.baseSize * 0.5;
+    if (bar_progress > 1)
+        bar_progress = 1;
+    float bar_x = (float)w / 2 - bar_width / 2;
+    float bar_y = (float)p->font.baseSize / 2 + bar_padding_top;
+
+    Rectangle bar_filling = {
+        .x = bar_x,
+        .y = bar_y,
+        .width = bar_width * bar_progress,
+        .height = bar_height,
+    };
+    DrawRectangleRec(bar_filling, WHITE);
+
+    Rectangle bar_box = {
+        .x = bar_x,
+        .y = bar_y,
+        .width = bar_width,
+        .height = bar_height,
+    };
+    DrawRectangleLinesEx(bar_box, 2, WHITE);
+}
+
+// the speed of the render, when it's going to be done and what holds it back
+static void rendering_stats(int w, int h)
+{
+    double elapsed = clock_now() - p->render_started;
+    size_t frames = p->render_frame_index - p->render_first_frame;
+    if (elapsed <= 0 || frames == 0)
+        return;
+    double fps = frames / elapsed;
+
+    size_t left = 0;
+    if (p->render_last_frame != RENDER_JOB_END) {
+        left = p->render_last_frame - p->render_frame_index;
+    } else if (p->wave_cursor < p->wave.frameCount) {
+        size_t rate = p->wave.sampleRate;
+        size_t fps = p->render_profile.fps;
+        left = render_sample_frame(p->wave.frameCount, rate, fps) -
+               render_sample_frame(p->wave_cursor, rate, fps);
+    }
+    size_t eta = left / fps;
+
+    // NOTE: the slowest ffmpeg is the one that holds the render back
+    Encoder_Stats stats = {0};
+    for (size_t i = 0; i < p->output_count; ++i) {
+        Encoder_Stats s;
+        encoder_stats(p->outputs[i].encoder, &s);
+        if (i == 0 || s.ffmpeg.fps < stats.ffmpeg.fps)
+            stats = s;
+    }
+    const char *label = TextFormat(
+        "%.1f fps, ETA %zu:%02zu, bottleneck: %s (ffmpeg: %.1f fps, %.2fx)",
+        fps, eta / 60, eta % 60, render_stage_names[render_bottleneck()],
+        stats.ffmpeg.fps, stats.ffmpeg.speed);
+
+    int fontSize = p->font.baseSize / 2;
+    Vector2 size = MeasureTextEx(p->font, label, fontSize, 0);
+    Vector2 position = {
+        (float)w / 2 - size.x / 2,
+        (float)h / 2 + p->font.baseSize,
+    };
+    draw_text(label, position, fontSize, GRAY);
+}
+
+// the workers do the rendering, this only keeps an eye on them
+static void rendering_segments_screen(Track *track, int w, int h)
+{
+    segments_update(&p->segments);
+
+    switch (p->segments.state) {
+    case SEGMENTS_FAILED:
+        if (IsKeyPressed(KEY_ESCAPE))
+            render_stop(track);
+        rendering_failure(w, h);
+        break;
+    case SEGMENTS_DONE:
+        render_stop(track);
+        break;
+    case SEGMENTS_RENDERING:
+    case SEGMENTS_JOINING:
+        if (IsKeyPressed(KEY_ESCAPE)) {
+            render_stop(track);
+        } else if (p->segments.state == SEGMENTS_RENDERING) {
+            size_t count = p->segments.workers.count;
+            rendering_progress(
+                w, h,
+                TextFormat("Rendering video (%s, %zu/%zu segments)...",
+                           p->render_profile.name, p->segments.finished,
+                           count),
+                (float)p->segments.finished / count);
+        } else {
+            rendering_progress(w, h, "Joining segments...", 1);
+        }
+        break;
+    }
+}
+
 void rendering_screen()
 {
 #ifdef __APPLE__
@@ -1040,120 +2815,68 @@ void rendering_screen()
 
     Track *track = current_track();
     NOB_ASSERT(track != NULL);
-    if (p->ffmpeg == NULL) { // starting FFMPEG process has failed
+    if (p->render_segmented) {
+        rendering_segments_screen(track, w, h);
+    } else if (!render_encoding()) { // an FFMPEG process has failed
         if (IsKeyPressed(KEY_ESCAPE)) {
-            SetTraceLogLevel(LOG_INFO);
-            UnloadWave(p->wave);
-            UnloadWaveSamples(p->wave_samples);
-            p->rendering = false;
-            fft_clean();
-            PlayMusicStream(track->music);
+            render_stop(track);
         }
-
-        const char *label = "FFmpeg Failure: Check the Logs";
-        Color color = RED;
-        int fontSize = p->font.baseSize;
-        Vector2 size = MeasureTextEx(p->font, label, fontSize, 0);
-        Vector2 position = {
-            (float)w / 2 - size.x / 2,
-            (float)h / 2 - size.y / 2,
-        };
-        DrawTextEx(p->font, label, position, fontSize, 0, color);
-
-        label = "(Press ESC to Continue)";
-        fontSize = p->font.baseSize * 2 / 3;
-        size = MeasureTextEx(p->font, label, fontSize, 0);
-        position.x = (float)w / 2 - size.x / 2;
-        position.y = (float)h / 2 - size.y / 2 + fontSize;
-        DrawTextEx(p->font, label, position, fontSize, 0, color);
+        rendering_failure(w, h);
     } else { // FFMPEG process is going
-        // TODO: introduce a rendering mode that perfectly loops the
-        // video
-        if ((p->wave_cursor >= p->wave.frameCount && fft_settled()) ||
-            IsKeyPressed(KEY_ESCAPE)) {
-            if (!ffmpeg_end_rendering(p->ffmpeg)) {
-                p->ffmpeg = NULL;
-            } else {
-                SetTraceLogLevel(LOG_INFO);
-                UnloadWave(p->wave);
-                UnloadWaveSamples(p->wave_samples);
-                p->rendering = false;
-                fft_clean();
-                PlayMusicStream(track->music);
+        if (render_done() || IsKeyPressed(KEY_ESCAPE)) {
+            if (render_encoding()) {
+                if (render_finish(NULL))
+                    render_stop(track);
             }
         } else { // rendering...
 
-            // label
-            const char *label = "Rendering video...";
-            Color color = WHITE;
-
-            Vector2 size = MeasureTextEx(p->font, label, p->font.baseSize, 0);
-            Vector2 position = {
-                (float)w / 2 - size.x / 2,
-                (float)h / 2 - size.y / 2,
-            };
-            DrawTextEx(p->font, label, position, p->font.baseSize, 0, color);
-
-            // progress bar
-            float bar_width = (float)w * 2 / 3;
-            float bar_height = p->font.baseSize * 0.25;
-            float bar_progress = (float)p->wave_cursor / p->wave.frameCount;
-            float bar_padding_top = p->font.baseSize * 0.5;
-            if (bar_progress > 1)
-                bar_progress = 1;
-            float bar_x = (float)w / 2 - bar_width / 2;
-            float bar_y = (float)p->font.baseSize / 2 + bar_padding_top;
-
-            Rectangle bar_filling = {
-                .x = bar_x,
-                .y = bar_y,
-                .width = bar_width * bar_progress,
-                .height = bar_height,
-            };
-            DrawRectangleRec(bar_filling, WHITE);
+            // as many frames as fit in the budget; the screen below is only
+            // refreshed between two batches
+            double batch_start = GetTime();
+            do {
+                render_frame();
+            } while (render_encoding() && !render_done() &&
+                     GetTime() - batch_start < RENDER_BATCH_SECS);
+
+            rendering_progress(w, h,
+                               TextFormat("Rendering video (%s)...",
+                                          render_outputs_label()),
+                               render_progress());
+            if (render_encoding())
+                rendering_stats(w, h);
+        }
+    }
+}
 
-            Rectangle bar_box = {
-                .x = bar_x,
-                .y = bar_y,
-                .width = bar_width,
-                .height = bar_height,
-            };
-            DrawRectangleLinesEx(bar_box, 2, WHITE);
-
-            // rendering
-            {
-                size_t chunk_size = p->wave.sampleRate / RENDER_FPS;
-                // https://cdecl.org/?q=float+%28*fs%29%5B2%5D
-                float *fs = (float *)p->wave_samples;
-                for (size_t i = 0; i < chunk_size; ++i) {
-                    if (p->wave_cursor < p->wave.frameCount) {
-                        fft_push(fs[p->wave_cursor * p->wave.channels + 0]);
-                    } else {
-                        fft_push(0);
-                    }
-                    p->wave_cursor += 1;
-                }
-            }
+// NOTE: the glyphs are signed distance fields, crisp at any size through
+//       sdf.fs; a mipmapped bitmap font is the fallback when it doesn't
+//       compile
+static void load_font(const char *file_path)
+{
+    p->font_sdf = p->sdf.id != rlGetShaderIdDefault();
+    if (!p->font_sdf) {
+        p->font = LoadFontEx(file_path, FONT_SIZE, NULL, 0);
+        GenTextureMipmaps(&p->font.texture);
+        SetTextureFilter(p->font.texture, TEXTURE_FILTER_BILINEAR);
+        return;
+    }
 
-            size_t m = fft_analyze(1.0f / RENDER_FPS);
-
-            BeginTextureMode(p->screen);
-            ClearBackground(COLOR_BACKGROUND);
-            fft_render(CLITERAL(Rectangle){0, 0, p->screen.texture.width,
-                                           p->screen.texture.height},
-                       m);
-            EndTextureMode();
-
-            Image image = LoadImageFromTexture(p->screen.texture);
-            if (!ffmpeg_send_frame_flipped(p->ffmpeg, image.data,
-                                           p->screen.texture.width,
-                                           p->screen.texture.height)) {
-                ffmpeg_end_rendering(p->ffmpeg);
-                p->ffmpeg = NULL;
-            }
-            UnloadImage(image);
-        }
+    int size = 0;
+    unsigned char *data = LoadFileData(file_path, &size);
+    p->font = (Font){.baseSize = FONT_SIZE, .glyphCount = 95};
+    p->font.glyphs = LoadFontData(data, size, FONT_SIZE, NULL, 0, FONT_SDF);
+    if (p->font.glyphs == NULL) {
+        UnloadFileData(data);
+        p->font_sdf = false;
+        p->font = GetFontDefault();
+        return;
     }
+    Image atlas = GenImageFontAtlas(p->font.glyphs, &p->font.recs,
+                                    p->font.glyphCount, FONT_SIZE, 0, 1);
+    p->font.texture = LoadTextureFromImage(atlas);
+    SetTextureFilter(p->font.texture, TEXTURE_FILTER_BILINEAR);
+    UnloadImage(atlas);
+    UnloadFileData(data);
 }
 
 void plug_init()
@@ -1162,18 +2885,33 @@ void plug_init()
     assert(p != NULL && "Upgrade your memory!!");
     memset(p, 0, sizeof(*p)); // fill a block of memory
 
-    p->font = LoadFontEx("./resources/fonts/Alegreya-Regular.ttf", FONT_SIZE,
-                         NULL, 0);
-    GenTextureMipmaps(&p->font.texture);
-    SetTextureFilter(p->font.texture, TEXTURE_FILTER_BILINEAR);
+    p->sdf = LoadShader(
+        NULL, TextFormat("./resources/shaders/glsl%d/sdf.fs", GLSL_VERSION));
+    load_font(FONT_PATH);
 
     p->circle = LoadShader(
         NULL, TextFormat("./resources/shaders/glsl%d/circle.fs", GLSL_VERSION));
     p->circle_radius_location = GetShaderLocation(p->circle, "radius");
     p->circle_power_location = GetShaderLocation(p->circle, "power");
-
-    p->screen = LoadRenderTexture(RENDER_WIDTH, RENDER_HEIGHT);
+    p->yuv420 = LoadShader(
+        NULL, TextFormat("./resources/shaders/glsl%d/yuv420.fs", GLSL_VERSION));
+    p->yuv420_size_location = GetShaderLocation(p->yuv420, "size");
+    bands_load_shader(
+        &p->bands,
+        TextFormat("./resources/shaders/glsl%d/bands.vs", GLSL_VERSION),
+        TextFormat("./resources/shaders/glsl%d/bands.fs", GLSL_VERSION));
+    bands_load_visualizer(
+        &p->bands,
+        TextFormat("./resources/shaders/glsl%d/visualizer.fs", GLSL_VERSION));
+    bloom_load_shader(
+        &p->bloom,
+        TextFormat("./resources/shaders/glsl%d/bloom.fs", GLSL_VERSION));
+
+    render_profiles_reload();
     p->current_track = -1;
+    p->target_fps = IDLE_ACTIVE_FPS; // set by main()
+    governor_init(&p->governor, QUALITY_BUDGET_SECS,
+                  NOB_ARRAY_LEN(quality_tiers));
 
     // TODO: restore master volume between sessions
     SetMasterVolume(0.5);
@@ -1192,6 +2930,24 @@ Plug *plug_pre_reload()
 void plug_post_reload(Plug *prev)
 {
     p = prev;
+    UnloadShader(p->sdf);
+    p->sdf = LoadShader(
+        NULL, TextFormat("./resources/shaders/glsl%d/sdf.fs", GLSL_VERSION));
+    // NOTE: distance fields drawn without sdf.fs are a blur, the font follows
+    //       the shader
+    if (p->font_sdf != (p->sdf.id != rlGetShaderIdDefault())) {
+        if (p->font.texture.id != GetFontDefault().texture.id)
+            UnloadFont(p->font);
+        load_font(FONT_PATH);
+        // the labels were measured with the other font
+        for (size_t i = 0; i < p->tracks.count; ++i)
+            p->tracks.items[i].label_font_size = 0;
+    }
+    // NOTE: the code that draws them may have changed
+    p->ui_tracks.valid = false;
+    p->ui_timeline.valid = false;
+    p->ui_fullscreen.valid = false;
+    p->ui_volume.valid = false;
     for (size_t i = 0; i < p->tracks.count; ++i) {
         Track *it = &p->tracks.items[i];
         AttachAudioStreamProcessor(it->music.stream, callback);
@@ -1201,13 +2957,131 @@ void plug_post_reload(Plug *prev)
         NULL, TextFormat("./resources/shaders/glsl%d/circle.fs", GLSL_VERSION));
     p->circle_radius_location = GetShaderLocation(p->circle, "radius");
     p->circle_power_location = GetShaderLocation(p->circle, "power");
+    UnloadShader(p->yuv420);
+    p->yuv420 = LoadShader(
+        NULL, TextFormat("./resources/shaders/glsl%d/yuv420.fs", GLSL_VERSION));
+    p->yuv420_size_location = GetShaderLocation(p->yuv420, "size");
+    bands_load_shader(
+        &p->bands,
+        TextFormat("./resources/shaders/glsl%d/bands.vs", GLSL_VERSION),
+        TextFormat("./resources/shaders/glsl%d/bands.fs", GLSL_VERSION));
+    bands_load_visualizer(
+        &p->bands,
+        TextFormat("./resources/shaders/glsl%d/visualizer.fs", GLSL_VERSION));
+    bloom_load_shader(
+        &p->bloom,
+        TextFormat("./resources/shaders/glsl%d/bloom.fs", GLSL_VERSION));
+}
+
+void plug_deinit()
+{
+    // NOTE: called while the GL context is still there, before CloseWindow()
+    governor_free(&p->governor);
+    UnloadRenderTexture(p->preview);
+    UnloadRenderTexture(p->ui_tracks.target);
+    UnloadRenderTexture(p->ui_timeline.target);
+    UnloadRenderTexture(p->ui_fullscreen.target);
+    UnloadRenderTexture(p->ui_volume.target);
+    for (size_t i = 0; i < RENDER_MAX_OUTPUTS; ++i) {
+        Render_Output *o = &p->outputs[i];
+        UnloadRenderTexture(o->screen);
+        UnloadRenderTexture(o->yuv);
+        bloom_free(&o->bloom);
+    }
+    bands_free(&p->bands);
+    if (p->bloom.shader.id != 0)
+        UnloadShader(p->bloom.shader);
+    UnloadShader(p->circle);
+    UnloadShader(p->yuv420);
+    UnloadShader(p->sdf);
+    if (p->font.texture.id != GetFontDefault().texture.id)
+        UnloadFont(p->font);
+}
+
+// something was done with the mouse, the keyboard or the window
+static bool plug_input()
+{
+    Vector2 delta = GetMouseDelta();
+    if (delta.x != 0 || delta.y != 0 || GetMouseWheelMove() != 0)
+        return true;
+    for (int b = MOUSE_BUTTON_LEFT; b <= MOUSE_BUTTON_BACK; ++b) {
+        if (IsMouseButtonDown(b))
+            return true;
+    }
+    // NOTE: nothing else reads the queue of the keys pressed
+    return GetKeyPressed() != 0 || IsWindowResized() || IsFileDropped();
+}
+
+// NOTE: the frame rate of the UI: with nothing that moves on its own (no
+//       track playing, the bands at rest, no render, no microphone) and no
+//       input for a while, EndDrawing() waits for the next event (raylib's
+//       event waiting) so the window is only drawn again when something
+//       happens; a window in the background is drawn less often
+static void plug_idle()
+{
+    double now = GetTime();
+    if (plug_input())
+        p->last_input = now;
+
+    Track *track = current_track();
+    bool playing = track != NULL && IsMusicStreamPlaying(track->music);
+#ifdef FEATURE_MICROPHONE
+    playing = playing || p->capturing;
+#endif // FEATURE_MICROPHONE
+    bool hidden = IsWindowHidden() || IsWindowMinimized();
+    bool moving = p->rendering || playing || (track != NULL && !p->fft_still);
+
+    int fps = IDLE_ACTIVE_FPS;
+    if (!moving && (hidden || now - p->last_input > IDLE_AFTER_SECS)) {
+        fps = 0;
+    } else if (!p->rendering && (hidden || !IsWindowFocused())) {
+        fps = playing ? IDLE_BACKGROUND_FPS : IDLE_SETTLING_FPS;
+    }
+    if (fps == p->target_fps)
+        return;
+
+    if (fps == 0) {
+        EnableEventWaiting();
+    } else {
+        if (p->target_fps == 0)
+            DisableEventWaiting();
+        SetTargetFPS(fps);
+    }
+    p->target_fps = fps;
+}
+
+// the tier of the preview and the time a frame takes, toggled by F3
+static void governor_hud()
+{
+    const Governor *g = &p->governor;
+    const Quality_Tier *tier = &quality_tiers[g->tier];
+    const char *gpu =
+        g->gpu > 0 ? TextFormat("%.1f ms", g->gpu * 1000) : "n/a";
+    const char *text = TextFormat(
+        "quality %s (%zu/%zu): %d%%, step %.2f, fft %zu, glow %s\n"
+        "cpu %.1f ms, gpu %s, budget %.1f ms",
+        tier->name, g->tier + 1, g->tier_count, (int)(tier->scale * 100),
+        tier->band_step, tier->fft_size, tier->glow ? "on" : "off",
+        g->cpu * 1000, gpu, g->budget * 1000);
+    float size = FONT_SIZE / 3;
+    Vector2 extent = MeasureTextEx(p->font, text, size, 0);
+    DrawRectangle(0, 0, extent.x + size, extent.y + size,
+                  ColorAlpha(BLACK, 0.6));
+    draw_text(text, CLITERAL(Vector2){size / 2, size / 2}, size, WHITE);
 }
 
 void plug_update()
 {
+    p->frame_started = clock_now();
+    if (IsKeyPressed(KEY_F3))
+        p->governor_hud = !p->governor_hud;
 
     BeginDrawing();
     ClearBackground(COLOR_BACKGROUND);
+    // NOTE: a render draws as many frames as it can, it's not governed
+    bool governed = !p->rendering;
+    if (governed)
+        governor_begin_gpu(&p->governor);
 
     if (!p->rendering) {
 #ifdef FEATURE_MICROPHONE
@@ -1223,9 +3097,151 @@ void plug_update()
         rendering_screen();
     }
 
+    if (governed) {
+        if (p->governor_hud)
+            governor_hud();
+        // NOTE: the last batch (the panels, the HUD, the text...) is only
+        //       drawn by EndDrawing() otherwise, outside of the query
+        rlDrawRenderBatchActive();
+        governor_end_gpu(&p->governor);
+        governor_frame(&p->governor, clock_now() - p->frame_started,
+                       GetFrameTime());
+    }
+
+    plug_idle();
     EndDrawing();
 }
 
+// the state of the plugin when it's used without the UI (plug_init() is only
+// called when there's a window)
+static void plug_headless()
+{
+    if (p == NULL) {
+        p = malloc(sizeof(*p));
+        assert(p != NULL && "Upgrade your memory!!");
+        memset(p, 0, sizeof(*p));
+        p->current_track = -1;
+    }
+}
+
+static const Render_Profile *render_profile_find(const char *name)
+{
+    render_profiles_reload();
+    for (size_t i = 0; i < p->profiles.count; ++i) {
+        if (strcmp(p->profiles.items[i].name, name) == 0)
+            return &p->profiles.items[i];
+    }
+    TraceLog(LOG_ERROR, "RENDER: no render profile %s in %s", name,
+             RENDER_PROFILES_PATH);
+    return NULL;
+}
+
+bool plug_render(const Render_Job *job, Render_Stats *stats)
+{
+    // NOTE: without a window there's no GL context, only the software
+    //       renderer can be used
+    bool headless = !IsWindowReady();
+    plug_headless();
+
+    const Render_Profile *found = render_profile_find(job->profile);
+    if (found == NULL)
+        return false;
+    p->render_profile = *found;
+    if (headless && !p->render_profile.software) {
+        TraceLog(LOG_ERROR, "RENDER: profile %s needs a window (renderer = "
+                            "software does not)",
+                 job->profile);
+        return false;
+    }
+    if (job->loop &&
+        (job->loop_first >= job->loop_last || job->last_frame > job->loop_last ||
+         job->first_frame < job->loop_first)) {
+        TraceLog(LOG_ERROR, "RENDER: frames %zu..%zu are not in the loop "
+                            "%zu..%zu",
+                 job->first_frame, job->last_frame, job->loop_first,
+                 job->loop_last);
+        return false;
+    }
+    if (job->output != NULL) {
+        if (strlen(job->output) >= sizeof(p->render_profile.output)) {
+            TraceLog(LOG_ERROR, "RENDER: output path %s is too long",
+                     job->output);
+            return false;
+        }
+        strcpy(p->render_profile.output, job->output);
+    }
+
+    p->rendering = true;
+    bool ok = render_begin(job);
+    while (render_encoding() && !render_done())
+        render_frame();
+    ok = render_finish(stats) && ok;
+    render_end();
+    p->rendering = false;
+    return ok;
+}
+
+bool plug_analyze(const char *file_path, const char *profile)
+{
+    plug_headless();
+    const Render_Profile *found = render_profile_find(profile);
+    if (found == NULL)
+        return false;
+    size_t fps = found->fps;
+
+    render_source_open(file_path);
+    if (p->wave.sampleRate / fps == 0) {
+        TraceLog(LOG_ERROR, "ANALYZE: could not load %s", file_path);
+        render_source_close();
+        return false;
+    }
+    Spectrum_Info info = {
+        .n = N,
+        .fps = fps,
+        .band_step = FFT_BAND_STEP,
+        .hop = p->wave.sampleRate / fps,
+        .sample_rate = p->wave.sampleRate,
+        .source_frames = p->wave.frameCount,
+    };
+    Spectrum_Writer *writer = spectrum_write_start(file_path, &info);
+    if (writer == NULL) {
+        render_source_close();
+        return false;
+    }
+
+    // NOTE: the frames go on until the analysis window is past the end of
+    //       the track, the spectrum is silent after them
+    double started = clock_now();
+    size_t frame_count =
+        render_sample_frame(p->wave.frameCount + N, p->wave.sampleRate, fps);
+    fft_clean();
+    p->render_silence = 0;
+    size_t m = 0;
+    for (size_t i = 0; i < frame_count; ++i) {
+        size_t chunk_size = render_chunk_size(fps);
+        float *chunk = fft_push_many(chunk_size);
+        render_source_read(chunk, chunk_size);
+        render_track_silence(chunk, chunk_size);
+        if (p->render_silence >= N && m > 0) {
+            memset(p->out_log, 0, m * sizeof(p->out_log[0]));
+        } else {
+            m = fft_bands(N, FFT_BAND_STEP);
+        }
+        spectrum_write_frame(writer, p->out_log, m);
+    }
+    bool ok = spectrum_write_end(writer);
+    render_source_close();
+    fft_clean();
+
+    double seconds = clock_now() - started;
+    if (ok)
+        TraceLog(LOG_WARNING, "ANALYZE: %s: %zu frames in %.2fs (%.0fx real "
+                              "time)",
+                 file_path, frame_count, seconds,
+                 seconds > 0 ? (double)frame_count / fps / seconds : 0.0);
+    return ok;
+}
+
 // TODO: introduce the notion of active UI element to get rid of the bugs when
 // you're dragging something and unpress the mouse over another element and
 // accidentally activate it.
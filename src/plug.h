@@ -1,11 +1,45 @@
 #ifndef PLUG_H_
 #define PLUG_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+
+#define RENDER_JOB_END ((size_t)-1)
+
+// a render without the UI, e.g. one segment of a segmented render
+typedef struct {
+    const char *file_path;
+    const char *profile; // name of a render profile
+    const char *output;  // NULL: the output of the profile
+    size_t first_frame;
+    size_t last_frame; // RENDER_JOB_END: until the music fades out
+    bool video_only;
+    // the frames are part of a seamless loop over [loop_first, loop_last):
+    // the analysis before `loop_first` wraps around to the end of the loop
+    // and its last frames fade into the state of its first one
+    bool loop;
+    size_t loop_first;
+    size_t loop_last;
+} Render_Job;
+
+typedef struct {
+    size_t frames;      // video frames sent to FFmpeg
+    double encoder_wait; // seconds spent waiting for the encoder
+} Render_Stats;
+
+// NOTE: plug_analyze(track, profile) saves the analysis of every frame of the
+//       track at the fps of the profile next to it (see spectrum.h)
+// NOTE: plug_deinit() releases what plug_init() and the frames since then
+//       made on the GPU, before the window (and the GL context) is closed
+
 #define LIST_OF_PLUGS                                                          \
     PLUG(plug_init, void, void)                                                \
     PLUG(plug_pre_reload, void *, void)                                        \
     PLUG(plug_post_reload, void, void *)                                       \
-    PLUG(plug_update, void, void)
+    PLUG(plug_update, void, void)                                              \
+    PLUG(plug_render, bool, const Render_Job *, Render_Stats *)                \
+    PLUG(plug_analyze, bool, const char *, const char *)                       \
+    PLUG(plug_deinit, void, void)
 
 #define PLUG(name, ret, ...) typedef ret(name##_t)(__VA_ARGS__);
 LIST_OF_PLUGS
@@ -0,0 +1,291 @@
+#include "profile.h"
+#include "pcm.h"
+#include "raylib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// NOTE: the implementation of nob.h lives in plug.c
+
+Render_Profile render_profile_default(void)
+{
+    Render_Profile profile = {
+        .name = "default",
+        .width = 16 * 100,
+        .height = 9 * 100,
+        .fps = 30,
+        .segments = 1,
+        .pix_fmt = "yuv420p",
+        .vcodec = "libx264",
+        .crf = -1,
+        .bitrate = "2500k",
+        .acodec = "aac",
+        .abitrate = "200k",
+        .output = "output.mp4",
+    };
+    return profile;
+}
+
+static bool profile_parse_string(const char *path, size_t row,
+                                 Nob_String_View value, char *dst,
+                                 size_t capacity)
+{
+    if (value.count >= capacity) {
+        TraceLog(LOG_ERROR, "PROFILE: %s:%zu: `" SV_Fmt "` is too long", path,
+                 row + 1, SV_Arg(value));
+        return false;
+    }
+    memcpy(dst, value.data, value.count);
+    dst[value.count] = '\0';
+    return true;
+}
+
+static bool profile_parse_number(const char *path, size_t row,
+                                 Nob_String_View value, size_t min, size_t max,
+                                 size_t *dst)
+{
+    char buffer[32];
+    if (value.count == 0 || value.count >= sizeof(buffer))
+        goto invalid;
+    memcpy(buffer, value.data, value.count);
+    buffer[value.count] = '\0';
+
+    char *end = NULL;
+    unsigned long n = strtoul(buffer, &end, 10);
+    if (*end != '\0' || n < min || n > max)
+        goto invalid;
+    *dst = n;
+    return true;
+
+invalid:
+    TraceLog(LOG_ERROR,
+             "PROFILE: %s:%zu: `" SV_Fmt "` is not a number in [%zu, %zu]",
+             path, row + 1, SV_Arg(value), min, max);
+    return false;
+}
+
+#define profile_parse_field(path, row, value, field)                           \
+    profile_parse_string(path, row, value, field, sizeof(field))
+
+static bool profile_parse_key(const char *path, size_t row, Nob_String_View key,
+                              Nob_String_View value, Render_Profile *profile)
+{
+    size_t n;
+    if (nob_sv_eq(key, nob_sv_from_cstr("width"))) {
+        // NOTE: yuv420p wants even dimensions
+        if (!profile_parse_number(path, row, value, 2, 8192, &n))
+            return false;
+        profile->width = n & ~(size_t)1;
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("height"))) {
+        if (!profile_parse_number(path, row, value, 2, 8192, &n))
+            return false;
+        profile->height = n & ~(size_t)1;
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("fps"))) {
+        if (!profile_parse_number(path, row, value, 1, 240, &profile->fps))
+            return false;
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("segments"))) {
+        if (!profile_parse_number(path, row, value, 1, 256,
+                                  &profile->segments))
+            return false;
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("checkpoint"))) {
+        if (!profile_parse_number(path, row, value, 0, 3600,
+                                  &profile->checkpoint))
+            return false;
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("renderer"))) {
+        profile->software = false;
+        profile->single_pass = false;
+        if (nob_sv_eq(value, nob_sv_from_cstr("software"))) {
+            profile->software = true;
+        } else if (nob_sv_eq(value, nob_sv_from_cstr("shader"))) {
+            profile->single_pass = true;
+        } else if (!nob_sv_eq(value, nob_sv_from_cstr("gpu"))) {
+            TraceLog(LOG_ERROR,
+                     "PROFILE: %s:%zu: `" SV_Fmt "` is neither gpu, shader "
+                     "nor software",
+                     path, row + 1, SV_Arg(value));
+            return false;
+        }
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("glow"))) {
+        if (nob_sv_eq(value, nob_sv_from_cstr("bloom"))) {
+            profile->bloom = true;
+        } else if (nob_sv_eq(value, nob_sv_from_cstr("circles"))) {
+            profile->bloom = false;
+        } else {
+            TraceLog(LOG_ERROR,
+                     "PROFILE: %s:%zu: `" SV_Fmt "` is neither circles nor "
+                     "bloom",
+                     path, row + 1, SV_Arg(value));
+            return false;
+        }
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("crf"))) {
+        if (!profile_parse_number(path, row, value, 0, 63, &n))
+            return false;
+        profile->crf = n;
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("pix_fmt"))) {
+        if (!nob_sv_eq(value, nob_sv_from_cstr("yuv420p")) &&
+            !nob_sv_eq(value, nob_sv_from_cstr("rgba"))) {
+            TraceLog(LOG_ERROR,
+                     "PROFILE: %s:%zu: `" SV_Fmt "` is neither yuv420p nor rgba",
+                     path, row + 1, SV_Arg(value));
+            return false;
+        }
+        return profile_parse_field(path, row, value, profile->pix_fmt);
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("vcodec"))) {
+        return profile_parse_field(path, row, value, profile->vcodec);
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("preset"))) {
+        return profile_parse_field(path, row, value, profile->preset);
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("bitrate"))) {
+        // the last of `crf` & `bitrate` wins
+        profile->crf = -1;
+        return profile_parse_field(path, row, value, profile->bitrate);
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("acodec"))) {
+        return profile_parse_field(path, row, value, profile->acodec);
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("abitrate"))) {
+        return profile_parse_field(path, row, value, profile->abitrate);
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("output"))) {
+        return profile_parse_field(path, row, value, profile->output);
+    } else if (nob_sv_eq(key, nob_sv_from_cstr("also"))) {
+        return profile_parse_field(path, row, value, profile->also);
+    } else {
+        TraceLog(LOG_ERROR, "PROFILE: %s:%zu: invalid key `" SV_Fmt "`", path,
+                 row + 1, SV_Arg(key));
+        return false;
+    }
+    return true;
+}
+
+bool render_profiles_load(const char *path, Render_Profiles *profiles)
+{
+    bool result = true;
+    Nob_String_Builder sb = {0};
+
+    profiles->count = 0;
+    if (!FileExists(path)) {
+        TraceLog(LOG_INFO, "PROFILE: no render profiles in %s", path);
+        nob_return_defer(true);
+    }
+    if (!nob_read_entire_file(path, &sb))
+        nob_return_defer(false);
+
+    Nob_String_View content = {
+        .data = sb.items,
+        .count = sb.count,
+    };
+
+    for (size_t row = 0; content.count > 0; ++row) {
+        Nob_String_View line =
+            nob_sv_trim(nob_sv_chop_by_delim(&content, '\n'));
+        if (line.count == 0 || line.data[0] == '#')
+            continue;
+
+        if (line.data[0] == '[') {
+            if (line.data[line.count - 1] != ']' || line.count < 3) {
+                TraceLog(LOG_ERROR, "PROFILE: %s:%zu: invalid section `" SV_Fmt
+                         "`", path, row + 1, SV_Arg(line));
+                nob_return_defer(false);
+            }
+            Render_Profile profile = render_profile_default();
+            Nob_String_View name = nob_sv_trim(
+                nob_sv_from_parts(line.data + 1, line.count - 2));
+            if (!profile_parse_field(path, row, name, profile.name))
+                nob_return_defer(false);
+            nob_da_append(profiles, profile);
+            continue;
+        }
+
+        Nob_String_View key = nob_sv_trim(nob_sv_chop_by_delim(&line, '='));
+        Nob_String_View value = nob_sv_trim(line);
+        if (profiles->count == 0) {
+            TraceLog(LOG_ERROR,
+                     "PROFILE: %s:%zu: `" SV_Fmt "` is outside of a profile",
+                     path, row + 1, SV_Arg(key));
+            nob_return_defer(false);
+        }
+        if (!profile_parse_key(path, row, key, value,
+                               &profiles->items[profiles->count - 1]))
+            nob_return_defer(false);
+    }
+
+    TraceLog(LOG_INFO, "PROFILE: loaded %zu render profiles from %s",
+             profiles->count, path);
+
+defer:
+    if (!result)
+        profiles->count = 0;
+    nob_sb_free(sb);
+    return result;
+}
+
+// `-i` and the options of the input that cut out the region of `audio`
+static void profile_audio_input(const Render_Audio *audio, Nob_Cmd *cmd)
+{
+    // NOTE: a raw track has no header for ffmpeg to probe
+    if (audio->format != NULL)
+        nob_cmd_append(cmd, "-f", audio->format, "-ar",
+                       nob_temp_sprintf("%d", PCM_RAW_SAMPLE_RATE), "-ac",
+                       nob_temp_sprintf("%d", PCM_RAW_CHANNELS));
+    if (audio->start > 0)
+        nob_cmd_append(cmd, "-ss", nob_temp_sprintf("%.6f", audio->start));
+    if (audio->duration > 0)
+        nob_cmd_append(cmd, "-t", nob_temp_sprintf("%.6f", audio->duration));
+    nob_cmd_append(cmd, "-i", audio->file_path);
+}
+
+static void profile_audio_args(const Render_Profile *profile, Nob_Cmd *cmd)
+{
+    // TODO: `auto` is meant to copy the audio of an AAC track, but no such
+    //       track can be loaded yet (neither raylib nor decoder.c and pcm.c
+    //       read AAC or MP4), so it's `aac`
+    const char *acodec = profile->acodec;
+    if (strcmp(acodec, "auto") == 0)
+        acodec = "aac";
+    if (strcmp(acodec, "copy") == 0) {
+        nob_cmd_append(cmd, "-c:a", "copy");
+    } else {
+        nob_cmd_append(cmd, "-c:a", acodec, "-b:a", profile->abitrate);
+    }
+}
+
+void render_profile_ffmpeg_args(const Render_Profile *profile,
+                                const Render_Audio *audio, Nob_Cmd *cmd)
+{
+    // NOTE: the strings live in the temporary storage of nob.h
+    const char *resolution =
+        nob_temp_sprintf("%zux%zu", profile->width, profile->height);
+    const char *framerate = nob_temp_sprintf("%zu", profile->fps);
+
+    nob_cmd_append(cmd, "-loglevel", "verbose", "-y");
+    nob_cmd_append(cmd, "-f", "rawvideo", "-pix_fmt", profile->pix_fmt, "-s",
+                   resolution, "-r", framerate, "-i", "-");
+    if (audio != NULL)
+        profile_audio_input(audio, cmd);
+
+    nob_cmd_append(cmd, "-c:v", profile->vcodec);
+    if (profile->preset[0] != '\0')
+        nob_cmd_append(cmd, "-preset", profile->preset);
+    if (profile->crf >= 0) {
+        nob_cmd_append(cmd, "-crf", nob_temp_sprintf("%d", profile->crf));
+    } else {
+        nob_cmd_append(cmd, "-b:v", profile->bitrate);
+    }
+
+    if (audio != NULL) {
+        profile_audio_args(profile, cmd);
+    } else {
+        nob_cmd_append(cmd, "-an");
+    }
+
+    nob_cmd_append(cmd, "-pix_fmt", "yuv420p", profile->output);
+}
+
+void render_profile_join_args(const Render_Profile *profile,
+                              const char *list_file_path,
+                              const Render_Audio *audio, Nob_Cmd *cmd)
+{
+    nob_cmd_append(cmd, "-loglevel", "verbose", "-y");
+    nob_cmd_append(cmd, "-f", "concat", "-safe", "0", "-i", list_file_path);
+    profile_audio_input(audio, cmd);
+    nob_cmd_append(cmd, "-map", "0:v", "-map", "1:a", "-c:v", "copy");
+    profile_audio_args(profile, cmd);
+    nob_cmd_append(cmd, profile->output);
+}
@@ -0,0 +1,77 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "nob.h"
+
+#define RENDER_PROFILES_PATH "./resources/render.conf"
+
+#define PROFILE_NAME_CAP     32
+#define PROFILE_CODEC_CAP    32
+#define PROFILE_PATH_CAP     256
+
+typedef struct {
+    char name[PROFILE_NAME_CAP];
+    size_t width;
+    size_t height;
+    size_t fps;
+    // rendered by as many worker processes, then joined (see segment.h)
+    size_t segments;
+    // seconds of video between two checkpoints of a render, 0: none (see
+    // checkpoint.h)
+    size_t checkpoint;
+    // drawn by softrender.h instead of OpenGL (`renderer = software`)
+    bool software;
+    // drawn in a single pass of visualizer.fs (`renderer = shader`)
+    bool single_pass;
+    // the glow of the circles comes from a bloom over the whole frame (see
+    // bloom.h) instead of each circle (`glow = bloom`)
+    bool bloom;
+    // the frames sent to ffmpeg: `yuv420p` (converted on the GPU) or `rgba`
+    char pix_fmt[PROFILE_CODEC_CAP];
+    char vcodec[PROFILE_CODEC_CAP];
+    char preset[PROFILE_CODEC_CAP]; // empty: the encoder's default
+    int crf;                        // -1: `bitrate` is used instead
+    char bitrate[PROFILE_CODEC_CAP];
+    // `copy` keeps the audio stream of the source, `auto` is `aac` (see
+    // profile_audio_args())
+    char acodec[PROFILE_CODEC_CAP];
+    char abitrate[PROFILE_CODEC_CAP];
+    char output[PROFILE_PATH_CAP];
+    // the names of the profiles rendered along with this one, separated by
+    // commas; they share its analysis, so they must share its fps too
+    char also[PROFILE_PATH_CAP];
+} Render_Profile;
+
+// the part of an audio track that goes along the video
+typedef struct {
+    const char *file_path;
+    const char *format; // of a raw track (see pcm_raw_format()), NULL if not
+    double start;       // seconds
+    double duration;    // seconds, 0: until the end of the track
+} Render_Audio;
+
+typedef struct {
+    Render_Profile *items;
+    size_t count;
+    size_t capacity;
+} Render_Profiles;
+
+// 1600x900 at 30 fps in yuv420p, libx264 at 2500k & AAC at 200k into output.mp4
+Render_Profile render_profile_default(void);
+// NOTE: the profiles are `[name]` sections of `key = value` lines; the
+//       profiles of a file that doesn't parse are all discarded
+bool render_profiles_load(const char *path, Render_Profiles *profiles);
+// the ffmpeg arguments (without the program name) that encode raw frames in
+// `pix_fmt` from stdin along with `audio` (no audio if NULL)
+void render_profile_ffmpeg_args(const Render_Profile *profile,
+                                const Render_Audio *audio, Nob_Cmd *cmd);
+// the ffmpeg arguments that join the videos listed in `list_file_path` (for
+// the concat demuxer) and mux `audio`
+void render_profile_join_args(const Render_Profile *profile,
+                              const char *list_file_path,
+                              const Render_Audio *audio, Nob_Cmd *cmd);
+
+#endif // PROFILE_H_
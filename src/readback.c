@@ -0,0 +1,87 @@
+#include "readback.h"
+#include "raylib.h"
+#include <assert.h>
+#include <string.h>
+
+// NOTE: the GL functions are the ones raylib loaded with glad
+#include "external/glad.h"
+
+bool readback_init(Readback *rb, int width, int height, size_t ring)
+{
+    assert(ring >= 2 && ring <= READBACK_MAX_RING);
+    memset(rb, 0, sizeof(*rb));
+    rb->ring = ring;
+    rb->width = width;
+    rb->height = height;
+    rb->frame_size = (size_t)width * height * 4;
+
+    glGenBuffers(ring, rb->pbos);
+    for (size_t i = 0; i < ring; ++i) {
+        if (rb->pbos[i] == 0) {
+            TraceLog(LOG_ERROR, "READBACK: could not create pixel buffers");
+            readback_free(rb);
+            return false;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbos[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, rb->frame_size, NULL,
+                     GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+void readback_free(Readback *rb)
+{
+    if (rb->mapped)
+        readback_unmap(rb);
+    for (size_t i = 0; i < rb->ring; ++i) {
+        if (rb->pbos[i] != 0)
+            glDeleteBuffers(1, &rb->pbos[i]);
+    }
+    memset(rb, 0, sizeof(*rb));
+}
+
+void readback_push(Readback *rb, unsigned int fbo)
+{
+    assert(!readback_full(rb) && !rb->mapped);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbos[rb->head]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, rb->width, rb->height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    rb->head = (rb->head + 1) % rb->ring;
+    rb->pending += 1;
+}
+
+const void *readback_map(Readback *rb)
+{
+    assert(!rb->mapped);
+    if (rb->pending == 0)
+        return NULL;
+
+    size_t oldest = (rb->head + rb->ring - rb->pending) % rb->ring;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbos[oldest]);
+    const void *data =
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rb->frame_size,
+                         GL_MAP_READ_BIT);
+    if (data == NULL) {
+        TraceLog(LOG_ERROR, "READBACK: could not map pixel buffer");
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        rb->pending -= 1;
+        return NULL;
+    }
+    rb->mapped = true;
+    return data;
+}
+
+void readback_unmap(Readback *rb)
+{
+    assert(rb->mapped);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    rb->mapped = false;
+    rb->pending -= 1;
+}
@@ -0,0 +1,36 @@
+#ifndef READBACK_H_
+#define READBACK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define READBACK_MAX_RING 4
+
+// NOTE: frames are read from the GPU asynchronously into a ring of pixel
+//       buffer objects; a frame is mapped once it's `ring - 1` frames old so
+//       glReadPixels() doesn't wait for the GPU to finish drawing
+typedef struct {
+    unsigned int pbos[READBACK_MAX_RING];
+    size_t ring;
+    size_t head;    // next PBO to read into
+    size_t pending; // frames read but not mapped yet
+    int width;
+    int height;
+    size_t frame_size;
+    bool mapped;
+} Readback;
+
+bool readback_init(Readback *rb, int width, int height, size_t ring);
+void readback_free(Readback *rb);
+// queue a read of the RGBA8 color buffer of the framebuffer `fbo`
+void readback_push(Readback *rb, unsigned int fbo);
+static inline bool readback_full(const Readback *rb)
+{
+    return rb->pending == rb->ring;
+}
+// map the oldest pending frame (NULL if none); readback_unmap() must be
+// called before the next push
+const void *readback_map(Readback *rb);
+void readback_unmap(Readback *rb);
+
+#endif // READBACK_H_
@@ -0,0 +1,604 @@
+#include "render_cli.h"
+#include "clock.h"
+#include <assert.h>
+#include <raylib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hotreload.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif // _WIN32
+
+// NOTE: this file is part of the executable, not of libplug, so it can't use
+//       nob.h whose implementation lives in plug.c
+
+#ifdef _WIN32
+#define RENDER_CLI_WORKER "musicalizer.exe"
+#else
+#define RENDER_CLI_WORKER "musicalizer"
+#endif // _WIN32
+
+#define RENDER_CLI_MAX_WORKERS 64
+#define RENDER_CLI_SUMMARY     "render-summary.json"
+#define RENDER_CLI_NO_JOB      ((size_t)-1)
+
+typedef struct {
+    char name[64];
+    char track[1024];
+    char profile[32];
+    char output[256]; // empty: the output of the profile
+
+    bool done;
+    bool ok;
+    int worker;
+    double started;
+    double seconds;
+    size_t frames;
+    double encoder_wait;
+} Cli_Job;
+
+typedef struct {
+    Cli_Job *items;
+    size_t count;
+    size_t capacity;
+} Cli_Jobs;
+
+static char *cli_trim(char *s)
+{
+    while (*s == ' ' || *s == '\t')
+        s += 1;
+    size_t n = strlen(s);
+    while (n > 0 && strchr(" \t\r\n", s[n - 1]) != NULL)
+        s[--n] = '\0';
+    return s;
+}
+
+static bool cli_copy(const char *path, size_t row, const char *value,
+                     char *dst, size_t capacity)
+{
+    // NOTE: the jobs are sent to the workers as tab separated lines
+    if (strlen(value) >= capacity || strchr(value, '\t') != NULL) {
+        TraceLog(LOG_ERROR, "RENDER: %s:%zu: invalid value `%s`", path, row,
+                 value);
+        return false;
+    }
+    strcpy(dst, value);
+    return true;
+}
+
+#define cli_copy_field(path, row, value, field)                                \
+    cli_copy(path, row, value, field, sizeof(field))
+
+static bool cli_load_jobs(const char *path, Cli_Jobs *jobs)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        TraceLog(LOG_ERROR, "RENDER: could not open %s", path);
+        return false;
+    }
+
+    bool ok = true;
+    char buffer[2048];
+    for (size_t row = 1; ok && fgets(buffer, sizeof(buffer), f) != NULL;
+         ++row) {
+        char *comment = strchr(buffer, '#');
+        if (comment != NULL)
+            *comment = '\0';
+        char *line = cli_trim(buffer);
+        if (*line == '\0')
+            continue;
+
+        if (*line == '[') {
+            size_t n = strlen(line);
+            if (line[n - 1] != ']') {
+                TraceLog(LOG_ERROR, "RENDER: %s:%zu: expected `]`", path, row);
+                ok = false;
+                break;
+            }
+            line[n - 1] = '\0';
+
+            if (jobs->count == jobs->capacity) {
+                jobs->capacity = jobs->capacity == 0 ? 16 : jobs->capacity * 2;
+                jobs->items = realloc(jobs->items,
+                                      jobs->capacity * sizeof(*jobs->items));
+                assert(jobs->items != NULL && "Buy more RAM!!");
+            }
+            Cli_Job *job = &jobs->items[jobs->count++];
+            memset(job, 0, sizeof(*job));
+            strcpy(job->profile, "default");
+            job->worker = -1;
+            ok = cli_copy_field(path, row, cli_trim(line + 1), job->name);
+            continue;
+        }
+
+        char *eq = strchr(line, '=');
+        if (eq == NULL || jobs->count == 0) {
+            TraceLog(LOG_ERROR, "RENDER: %s:%zu: expected `key = value` in a "
+                                "[job] section",
+                     path, row);
+            ok = false;
+            break;
+        }
+        *eq = '\0';
+        char *key = cli_trim(line);
+        char *value = cli_trim(eq + 1);
+        Cli_Job *job = &jobs->items[jobs->count - 1];
+        if (strcmp(key, "track") == 0) {
+            ok = cli_copy_field(path, row, value, job->track);
+        } else if (strcmp(key, "profile") == 0) {
+            ok = cli_copy_field(path, row, value, job->profile);
+        } else if (strcmp(key, "output") == 0) {
+            ok = cli_copy_field(path, row, value, job->output);
+        } else {
+            TraceLog(LOG_ERROR, "RENDER: %s:%zu: unknown key `%s`", path, row,
+                     key);
+            ok = false;
+        }
+    }
+    fclose(f);
+
+    for (size_t i = 0; ok && i < jobs->count; ++i) {
+        if (jobs->items[i].track[0] == '\0') {
+            TraceLog(LOG_ERROR, "RENDER: %s: job [%s] has no track", path,
+                     jobs->items[i].name);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static void cli_json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s != '\0'; ++s) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\') {
+            fprintf(f, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static bool cli_write_summary(const char *path, const Cli_Jobs *jobs,
+                              size_t workers, double seconds)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        TraceLog(LOG_ERROR, "RENDER: could not write %s", path);
+        return false;
+    }
+
+    size_t succeeded = 0;
+    size_t frames = 0;
+    fprintf(f, "{\n  \"jobs\": [");
+    for (size_t i = 0; i < jobs->count; ++i) {
+        const Cli_Job *job = &jobs->items[i];
+        succeeded += job->ok;
+        frames += job->frames;
+        fprintf(f, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        cli_json_string(f, job->name);
+        fprintf(f, ", \"track\": ");
+        cli_json_string(f, job->track);
+        fprintf(f, ", \"profile\": ");
+        cli_json_string(f, job->profile);
+        fprintf(f, ", \"output\": ");
+        if (job->output[0] != '\0') {
+            cli_json_string(f, job->output);
+        } else {
+            fprintf(f, "null");
+        }
+        fprintf(f,
+                ", \"ok\": %s, \"worker\": %d, \"started\": %.3f, \"seconds\": "
+                "%.3f, \"frames\": %zu, \"fps\": %.2f, \"encoder_wait\": "
+                "%.3f}",
+                job->ok ? "true" : "false", job->worker, job->started,
+                job->seconds, job->frames,
+                job->seconds > 0 ? job->frames / job->seconds : 0.0,
+                job->encoder_wait);
+    }
+    fprintf(f, "\n  ],\n");
+    fprintf(f, "  \"workers\": %zu,\n", workers);
+    fprintf(f, "  \"seconds\": %.3f,\n", seconds);
+    fprintf(f, "  \"frames\": %zu,\n", frames);
+    fprintf(f, "  \"succeeded\": %zu,\n", succeeded);
+    fprintf(f, "  \"failed\": %zu\n}\n", jobs->count - succeeded);
+
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+    if (!ok)
+        TraceLog(LOG_ERROR, "RENDER: could not write %s", path);
+    return ok;
+}
+
+static void cli_job_finished(Cli_Job *job, double start, bool ok,
+                             size_t frames, double encoder_wait)
+{
+    job->done = true;
+    job->ok = ok;
+    job->seconds = clock_now() - start - job->started;
+    job->frames = frames;
+    job->encoder_wait = encoder_wait;
+    TraceLog(ok ? LOG_WARNING : LOG_ERROR, "RENDER: [%s] %s in %.2fs",
+             job->name, ok ? "done" : "FAILED", job->seconds);
+}
+
+#ifdef _WIN32
+// NOTE: no worker processes on Windows yet, the jobs are rendered one after
+//       the other in this process
+static size_t cli_run(Cli_Jobs *jobs, size_t workers, bool software,
+                      double start)
+{
+    (void)workers;
+    if (!reload_libplug())
+        return 0;
+    if (!software) {
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(64, 64, "Musicalizer (render)");
+        plug_init();
+    }
+    for (size_t i = 0; i < jobs->count; ++i) {
+        Cli_Job *job = &jobs->items[i];
+        Render_Job render_job = {
+            .file_path = job->track,
+            .profile = job->profile,
+            .output = job->output[0] != '\0' ? job->output : NULL,
+            .last_frame = RENDER_JOB_END,
+        };
+        Render_Stats stats = {0};
+        job->worker = 0;
+        job->started = clock_now() - start;
+        bool ok = plug_render(&render_job, &stats);
+        cli_job_finished(job, start, ok, stats.frames, stats.encoder_wait);
+    }
+    if (!software) {
+        plug_deinit();
+        CloseWindow();
+    }
+    return 1;
+}
+#else
+typedef struct {
+    pid_t pid;
+    int jobs;    // write end of the worker's stdin
+    int results; // read end of the worker's stdout
+    char buffer[256];
+    size_t buffer_count;
+    size_t job; // RENDER_CLI_NO_JOB when idle
+    bool alive;
+} Cli_Worker;
+
+static bool cli_worker_spawn(Cli_Worker *w, bool software)
+{
+    int jobs[2], results[2];
+    if (pipe(jobs) < 0) {
+        TraceLog(LOG_ERROR, "RENDER: could not create a pipe: %s",
+                 strerror(errno));
+        return false;
+    }
+    if (pipe(results) < 0) {
+        TraceLog(LOG_ERROR, "RENDER: could not create a pipe: %s",
+                 strerror(errno));
+        close(jobs[0]);
+        close(jobs[1]);
+        return false;
+    }
+    // NOTE: the next workers must not inherit these, a worker only sees the
+    //       end of its jobs once every copy of the write end is closed
+    fcntl(jobs[1], F_SETFD, FD_CLOEXEC);
+    fcntl(results[0], F_SETFD, FD_CLOEXEC);
+
+    const char *path =
+        TextFormat("%s%s", GetApplicationDirectory(), RENDER_CLI_WORKER);
+    pid_t pid = fork();
+    if (pid < 0) {
+        TraceLog(LOG_ERROR, "RENDER: could not fork a worker: %s",
+                 strerror(errno));
+        close(jobs[0]);
+        close(jobs[1]);
+        close(results[0]);
+        close(results[1]);
+        return false;
+    }
+    if (pid == 0) {
+        dup2(jobs[0], STDIN_FILENO);
+        dup2(results[1], STDOUT_FILENO);
+        close(jobs[0]);
+        close(results[1]);
+        execl(path, path, "render-worker", software ? "--software" : NULL,
+              NULL);
+        fprintf(stderr, "RENDER: could not run %s: %s\n", path,
+                strerror(errno));
+        _exit(127);
+    }
+
+    close(jobs[0]);
+    close(results[1]);
+    memset(w, 0, sizeof(*w));
+    w->pid = pid;
+    w->jobs = jobs[1];
+    w->results = results[0];
+    w->job = RENDER_CLI_NO_JOB;
+    w->alive = true;
+    return true;
+}
+
+static bool cli_worker_send(Cli_Worker *w, const Cli_Job *job, size_t index)
+{
+    char line[sizeof(job->track) + sizeof(job->profile) + sizeof(job->output) +
+              32];
+    int n = snprintf(line, sizeof(line), "%zu\t%s\t%s\t%s\n", index,
+                     job->track, job->profile, job->output);
+    for (int written = 0; written < n;) {
+        ssize_t k = write(w->jobs, line + written, n - written);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return false;
+        written += k;
+    }
+    w->job = index;
+    return true;
+}
+
+static void cli_worker_died(Cli_Worker *w, Cli_Jobs *jobs, double start)
+{
+    w->alive = false;
+    if (w->job != RENDER_CLI_NO_JOB) {
+        TraceLog(LOG_ERROR, "RENDER: worker %d died", w->pid);
+        cli_job_finished(&jobs->items[w->job], start, false, 0, 0);
+        w->job = RENDER_CLI_NO_JOB;
+    }
+}
+
+// read the results of a worker, returns the number of jobs it finished
+static size_t cli_worker_read(Cli_Worker *w, Cli_Jobs *jobs, double start)
+{
+    ssize_t n = read(w->results, w->buffer + w->buffer_count,
+                     sizeof(w->buffer) - 1 - w->buffer_count);
+    if (n < 0 && errno == EINTR)
+        return 0;
+    if (n <= 0) {
+        size_t had_job = w->job != RENDER_CLI_NO_JOB;
+        cli_worker_died(w, jobs, start);
+        return had_job;
+    }
+    w->buffer_count += n;
+    w->buffer[w->buffer_count] = '\0';
+
+    size_t finished = 0;
+    char *line = w->buffer;
+    char *eol;
+    while ((eol = strchr(line, '\n')) != NULL) {
+        *eol = '\0';
+        size_t index, frames;
+        int ok;
+        double encoder_wait;
+        if (sscanf(line, "%zu %d %zu %lf", &index, &ok, &frames,
+                   &encoder_wait) == 4 &&
+            index == w->job) {
+            cli_job_finished(&jobs->items[index], start, ok != 0, frames,
+                             encoder_wait);
+            w->job = RENDER_CLI_NO_JOB;
+            finished += 1;
+        } else {
+            TraceLog(LOG_ERROR, "RENDER: unexpected answer from worker %d: %s",
+                     w->pid, line);
+        }
+        line = eol + 1;
+    }
+    w->buffer_count -= line - w->buffer;
+    memmove(w->buffer, line, w->buffer_count);
+    return finished;
+}
+
+// returns the number of workers that could be started
+static size_t cli_run(Cli_Jobs *jobs, size_t worker_count, bool software,
+                      double start)
+{
+    Cli_Worker workers[RENDER_CLI_MAX_WORKERS];
+    struct pollfd fds[RENDER_CLI_MAX_WORKERS];
+    Cli_Worker *polled[RENDER_CLI_MAX_WORKERS];
+
+    size_t spawned = 0;
+    while (spawned < worker_count &&
+           cli_worker_spawn(&workers[spawned], software))
+        spawned += 1;
+
+    size_t next = 0;
+    size_t finished = 0;
+    while (spawned > 0 && finished < jobs->count) {
+        // hand the next jobs to the idle workers
+        size_t alive = 0;
+        for (size_t i = 0; i < spawned; ++i) {
+            Cli_Worker *w = &workers[i];
+            if (w->alive && w->job == RENDER_CLI_NO_JOB && next < jobs->count) {
+                Cli_Job *job = &jobs->items[next];
+                job->worker = i;
+                job->started = clock_now() - start;
+                if (cli_worker_send(w, job, next)) {
+                    next += 1;
+                } else {
+                    w->alive = false;
+                }
+            }
+            alive += w->alive;
+        }
+        if (alive == 0)
+            break;
+
+        nfds_t n = 0;
+        for (size_t i = 0; i < spawned; ++i) {
+            if (workers[i].alive && workers[i].job != RENDER_CLI_NO_JOB) {
+                fds[n] = (struct pollfd){.fd = workers[i].results,
+                                         .events = POLLIN};
+                polled[n++] = &workers[i];
+            }
+        }
+        if (poll(fds, n, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            TraceLog(LOG_ERROR, "RENDER: could not poll the workers: %s",
+                     strerror(errno));
+            break;
+        }
+        for (nfds_t i = 0; i < n; ++i) {
+            if (fds[i].revents != 0)
+                finished += cli_worker_read(polled[i], jobs, start);
+        }
+    }
+
+    // whatever wasn't rendered failed
+    for (size_t i = 0; i < jobs->count; ++i) {
+        Cli_Job *job = &jobs->items[i];
+        if (job->done)
+            continue;
+        if (job->worker < 0)
+            job->started = clock_now() - start;
+        cli_job_finished(job, start, false, 0, 0);
+    }
+
+    // NOTE: a worker quits once its stdin is closed
+    for (size_t i = 0; i < spawned; ++i) {
+        close(workers[i].jobs);
+        close(workers[i].results);
+        waitpid(workers[i].pid, NULL, 0);
+    }
+    return spawned;
+}
+#endif // _WIN32
+
+int render_cli(int argc, char **argv)
+{
+    size_t workers = 1;
+    bool software = false;
+    const char *summary = RENDER_CLI_SUMMARY;
+    const char *jobs_path = NULL;
+
+    bool usage = false;
+    for (int i = 0; i < argc && !usage; ++i) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            char *end = NULL;
+            workers = strtoul(argv[++i], &end, 10);
+            usage = *end != '\0' || workers == 0 ||
+                    workers > RENDER_CLI_MAX_WORKERS;
+        } else if (strcmp(argv[i], "--software") == 0) {
+            software = true;
+        } else if (strcmp(argv[i], "--summary") == 0 && i + 1 < argc) {
+            summary = argv[++i];
+        } else if (jobs_path == NULL && argv[i][0] != '-') {
+            jobs_path = argv[i];
+        } else {
+            usage = true;
+        }
+    }
+    if (usage || jobs_path == NULL) {
+        fprintf(stderr,
+                "Usage: musicalizer render [-j <1..%d>] [--software] "
+                "[--summary <file>] <jobs file>\n",
+                RENDER_CLI_MAX_WORKERS);
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    Cli_Jobs jobs = {0};
+    if (!cli_load_jobs(jobs_path, &jobs)) {
+        free(jobs.items);
+        return 1;
+    }
+    if (workers > jobs.count)
+        workers = jobs.count;
+
+    double start = clock_now();
+    size_t spawned = jobs.count > 0 ? cli_run(&jobs, workers, software, start)
+                                    : 0;
+    double seconds = clock_now() - start;
+
+    bool ok = cli_write_summary(summary, &jobs, spawned, seconds);
+    for (size_t i = 0; i < jobs.count; ++i)
+        ok = ok && jobs.items[i].ok;
+    TraceLog(LOG_WARNING, "RENDER: %zu jobs in %.2fs, summary in %s",
+             jobs.count, seconds, summary);
+    free(jobs.items);
+    return ok ? 0 : 1;
+}
+
+// a job is `<index>\t<track>\t<profile>\t<output>\n` (an empty output is the
+// one of the profile) and its result is `<index> <ok> <frames> <encoder
+// wait>\n`
+int render_cli_worker(int argc, char **argv)
+{
+    bool software = argc > 0 && strcmp(argv[0], "--software") == 0;
+
+#ifndef _WIN32
+    // NOTE: raylib logs to stdout which is where the results go, the logs
+    //       are moved to stderr
+    FILE *results = fdopen(dup(STDOUT_FILENO), "w");
+    if (results == NULL) {
+        fprintf(stderr, "RENDER: could not open the results: %s\n",
+                strerror(errno));
+        return 1;
+    }
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+#else
+    FILE *results = stdout;
+#endif // _WIN32
+
+    if (!reload_libplug())
+        return 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+    // NOTE: one hidden window, hence one GL context, for all the jobs
+    if (!software) {
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(64, 64, "Musicalizer (render)");
+        plug_init();
+    }
+
+    char line[2048];
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        char *fields[4] = {0};
+        char *at = line;
+        size_t count = 0;
+        for (; count < 4 && at != NULL; ++count) {
+            fields[count] = at;
+            at = strpbrk(at, "\t\n");
+            if (at != NULL)
+                *at++ = '\0';
+        }
+        if (count != 4) {
+            fprintf(stderr, "RENDER: invalid job: %s\n", line);
+            break;
+        }
+
+        Render_Job job = {
+            .file_path = fields[1],
+            .profile = fields[2],
+            .output = fields[3][0] != '\0' ? fields[3] : NULL,
+            .last_frame = RENDER_JOB_END,
+        };
+        Render_Stats stats = {0};
+        bool ok = plug_render(&job, &stats);
+        fprintf(results, "%s %d %zu %.3f\n", fields[0], ok, stats.frames,
+                stats.encoder_wait);
+        fflush(results);
+    }
+
+    if (!software) {
+        plug_deinit();
+        CloseWindow();
+    }
+    return 0;
+}
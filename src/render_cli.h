@@ -0,0 +1,22 @@
+#ifndef RENDER_CLI_H_
+#define RENDER_CLI_H_
+
+// `musicalizer render [-j N] [--software] [--summary <file>] <jobs file>`
+//
+// renders every job of the jobs file with up to N worker processes, each one
+// keeping its GL context (a hidden window) from one job to the next; a JSON
+// summary with the timings of every job is written at the end
+//
+// the jobs file is made of sections like the render profiles:
+//
+//     [intro]
+//     track = music/intro.flac
+//     profile = final        # optional, `default` otherwise
+//     output = out/intro.mp4 # optional, the output of the profile otherwise
+int render_cli(int argc, char **argv);
+
+// `musicalizer render-worker [--software]`: reads the jobs from stdin and
+// writes their results to stdout, one line each (see render_cli.c)
+int render_cli_worker(int argc, char **argv);
+
+#endif // RENDER_CLI_H_
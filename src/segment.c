@@ -0,0 +1,291 @@
+#include "segment.h"
+#include "raylib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif // _WIN32
+
+// NOTE: nob.h misspells it on Windows
+#ifndef NOB_INVALID_PROC
+#define NOB_INVALID_PROC INVALID_HANDLE_VALUE
+#endif // NOB_INVALID_PROC
+
+#ifdef _WIN32
+#define SEGMENT_WORKER "musicalizer.exe"
+#define SEGMENT_FFMPEG "ffmpeg.exe"
+#else
+#define SEGMENT_WORKER "musicalizer"
+#define SEGMENT_FFMPEG "ffmpeg"
+#endif // _WIN32
+
+// 1 if `proc` has exited successfully, 0 if it's still running, -1 otherwise
+static int proc_poll(Nob_Proc proc)
+{
+#ifdef _WIN32
+    DWORD result = WaitForSingleObject(proc, 0);
+    if (result == WAIT_TIMEOUT)
+        return 0;
+    DWORD exit_status = 1;
+    if (result == WAIT_FAILED || !GetExitCodeProcess(proc, &exit_status)) {
+        TraceLog(LOG_ERROR,
+                 "SEGMENT: could not wait on child process. System Error "
+                 "Code: %d",
+                 GetLastError());
+    } else if (exit_status != 0) {
+        TraceLog(LOG_ERROR, "SEGMENT: command exited with exit code %lu",
+                 exit_status);
+    }
+    CloseHandle(proc);
+    return exit_status == 0 ? 1 : -1;
+#else
+    int status = 0;
+    pid_t pid = waitpid(proc, &status, WNOHANG);
+    if (pid == 0)
+        return 0;
+    if (pid < 0) {
+        TraceLog(LOG_ERROR, "SEGMENT: could not wait on process %d: %s", proc,
+                 strerror(errno));
+        return -1;
+    }
+    if (!WIFEXITED(status)) {
+        TraceLog(LOG_ERROR, "SEGMENT: process %d was terminated", proc);
+        return -1;
+    }
+    if (WEXITSTATUS(status) != 0) {
+        TraceLog(LOG_ERROR, "SEGMENT: process %d exited with exit code %d",
+                 proc, WEXITSTATUS(status));
+        return -1;
+    }
+    return 1;
+#endif // _WIN32
+}
+
+static void proc_kill(Nob_Proc proc)
+{
+#ifdef _WIN32
+    TerminateProcess(proc, 1);
+    WaitForSingleObject(proc, INFINITE);
+    CloseHandle(proc);
+#else
+    kill(proc, SIGTERM);
+    waitpid(proc, NULL, 0);
+#endif // _WIN32
+}
+
+const char *segment_part_path(const char *output, size_t i)
+{
+    const char *ext = GetFileExtension(output);
+    if (ext != NULL && strpbrk(ext, "/\\") != NULL)
+        ext = NULL;
+    int stem = ext != NULL ? (int)(ext - output) : (int)strlen(output);
+    return nob_temp_sprintf("%.*s.part%03zu%s", stem, output, i,
+                            ext != NULL ? ext : "");
+}
+
+static const char *segment_list_path(const char *output)
+{
+    return nob_temp_sprintf("%s.parts.txt", output);
+}
+
+bool segments_start(Segments *segments, const Render_Job *job,
+                    const Render_Profile *profile, size_t frame_count,
+                    Render_Audio audio)
+{
+    memset(segments, 0, sizeof(*segments));
+    segments->state = SEGMENTS_RENDERING;
+    segments->profile = *profile;
+    segments->audio = audio;
+    segments->audio.file_path = strdup(job->file_path);
+    assert(segments->audio.file_path != NULL && "Buy more RAM!!");
+    segments->join = NOB_INVALID_PROC;
+
+    size_t first_frame = job->first_frame;
+    if (job->last_frame != RENDER_JOB_END)
+        frame_count = job->last_frame;
+    frame_count = frame_count > first_frame ? frame_count - first_frame : 0;
+
+    size_t count = profile->segments;
+    if (count > frame_count)
+        count = frame_count;
+    if (count == 0)
+        count = 1;
+
+    const char *worker =
+        TextFormat("%s%s", GetApplicationDirectory(), SEGMENT_WORKER);
+    size_t temp_checkpoint = nob_temp_save();
+    for (size_t i = 0; i < count; ++i) {
+        const char *first =
+            nob_temp_sprintf("%zu", first_frame + frame_count * i / count);
+        const char *last = "end";
+        if (i + 1 < count || job->last_frame != RENDER_JOB_END)
+            last = nob_temp_sprintf("%zu", first_frame +
+                                               frame_count * (i + 1) / count);
+
+        Nob_Cmd cmd = {0};
+        nob_cmd_append(&cmd, worker, "segment");
+        if (profile->software)
+            nob_cmd_append(&cmd, "--software");
+        if (job->loop)
+            nob_cmd_append(&cmd, "--loop",
+                           nob_temp_sprintf("%zu", job->loop_first),
+                           nob_temp_sprintf("%zu", job->loop_last));
+        nob_cmd_append(&cmd, job->file_path, profile->name, first, last,
+                       segment_part_path(profile->output, i));
+        Nob_Proc proc = nob_cmd_run_async(cmd);
+        nob_cmd_free(cmd);
+        if (proc == NOB_INVALID_PROC) {
+            segments_cancel(segments);
+            nob_temp_rewind(temp_checkpoint);
+            return false;
+        }
+        nob_da_append(&segments->workers, proc);
+    }
+    nob_temp_rewind(temp_checkpoint);
+
+    TraceLog(LOG_INFO, "SEGMENT: rendering %zu frames in %zu segments",
+             frame_count, count);
+    return true;
+}
+
+// write the list of the `count` parts of `profile->output` and append the
+// ffmpeg command that joins them to `cmd`
+// NOTE: the command uses temporary strings
+static bool segments_join_cmd(const Render_Profile *profile, size_t count,
+                              const Render_Audio *audio, Nob_Cmd *cmd)
+{
+    bool result = true;
+    Nob_String_Builder list = {0};
+
+    // NOTE: the concat demuxer resolves the paths from the directory of the
+    //       list which is the one of the parts
+    for (size_t i = 0; i < count; ++i) {
+        const char *name = GetFileName(segment_part_path(profile->output, i));
+        nob_sb_append_cstr(&list, "file '");
+        for (const char *c = name; *c != '\0'; ++c) {
+            if (*c == '\'') {
+                nob_sb_append_cstr(&list, "'\\''");
+            } else {
+                nob_da_append(&list, *c);
+            }
+        }
+        nob_sb_append_cstr(&list, "'\n");
+    }
+    const char *list_path = segment_list_path(profile->output);
+    if (!nob_write_entire_file(list_path, list.items, list.count))
+        nob_return_defer(false);
+
+    nob_cmd_append(cmd, SEGMENT_FFMPEG);
+    render_profile_join_args(profile, list_path, audio, cmd);
+
+defer:
+    nob_sb_free(list);
+    return result;
+}
+
+static bool segments_join_start(Segments *segments)
+{
+    size_t temp_checkpoint = nob_temp_save();
+    Nob_Cmd cmd = {0};
+    if (segments_join_cmd(&segments->profile, segments->workers.count,
+                          &segments->audio, &cmd))
+        segments->join = nob_cmd_run_async(cmd);
+    nob_cmd_free(cmd);
+    nob_temp_rewind(temp_checkpoint);
+    return segments->join != NOB_INVALID_PROC;
+}
+
+static void segments_remove_parts(const char *output, size_t count)
+{
+    size_t temp_checkpoint = nob_temp_save();
+    for (size_t i = 0; i < count; ++i)
+        remove(segment_part_path(output, i));
+    remove(segment_list_path(output));
+    nob_temp_rewind(temp_checkpoint);
+}
+
+bool segments_join(const Render_Profile *profile, size_t count,
+                   const Render_Audio *audio)
+{
+    size_t temp_checkpoint = nob_temp_save();
+    Nob_Cmd cmd = {0};
+    bool ok = segments_join_cmd(profile, count, audio, &cmd) &&
+              nob_cmd_run_sync(cmd);
+    nob_cmd_free(cmd);
+    nob_temp_rewind(temp_checkpoint);
+    if (ok)
+        segments_remove_parts(profile->output, count);
+    return ok;
+}
+
+void segments_update(Segments *segments)
+{
+    switch (segments->state) {
+    case SEGMENTS_RENDERING:
+        for (size_t i = 0; i < segments->workers.count; ++i) {
+            Nob_Proc *worker = &segments->workers.items[i];
+            if (*worker == NOB_INVALID_PROC)
+                continue;
+            int status = proc_poll(*worker);
+            if (status == 0)
+                continue;
+            *worker = NOB_INVALID_PROC;
+            if (status < 0) {
+                TraceLog(LOG_ERROR, "SEGMENT: segment %zu failed", i);
+                segments_cancel(segments);
+                return;
+            }
+            segments->finished += 1;
+        }
+        if (segments->finished == segments->workers.count) {
+            if (segments_join_start(segments)) {
+                segments->state = SEGMENTS_JOINING;
+            } else {
+                segments->state = SEGMENTS_FAILED;
+            }
+        }
+        break;
+    case SEGMENTS_JOINING: {
+        int status = proc_poll(segments->join);
+        if (status == 0)
+            break;
+        segments->join = NOB_INVALID_PROC;
+        if (status < 0) {
+            segments->state = SEGMENTS_FAILED;
+        } else {
+            segments_remove_parts(segments->profile.output,
+                                  segments->workers.count);
+            segments->state = SEGMENTS_DONE;
+        }
+    } break;
+    case SEGMENTS_DONE:
+    case SEGMENTS_FAILED:
+        break;
+    }
+}
+
+void segments_cancel(Segments *segments)
+{
+    for (size_t i = 0; i < segments->workers.count; ++i) {
+        if (segments->workers.items[i] != NOB_INVALID_PROC)
+            proc_kill(segments->workers.items[i]);
+        segments->workers.items[i] = NOB_INVALID_PROC;
+    }
+    if (segments->join != NOB_INVALID_PROC)
+        proc_kill(segments->join);
+    segments->join = NOB_INVALID_PROC;
+    if (segments->state != SEGMENTS_DONE)
+        segments->state = SEGMENTS_FAILED;
+}
+
+void segments_free(Segments *segments)
+{
+    segments_cancel(segments);
+    nob_da_free(segments->workers);
+    free((char *)segments->audio.file_path);
+    memset(segments, 0, sizeof(*segments));
+}
@@ -0,0 +1,52 @@
+#ifndef SEGMENT_H_
+#define SEGMENT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "nob.h"
+#include "plug.h"
+#include "profile.h"
+
+typedef enum {
+    SEGMENTS_RENDERING,
+    SEGMENTS_JOINING,
+    SEGMENTS_DONE,
+    SEGMENTS_FAILED,
+} Segments_State;
+
+// NOTE: a segmented render splits the video frames of a track between
+//       `profile.segments` worker processes (`musicalizer segment ...`, see
+//       main.c); each one renders its part without audio and the parts are
+//       then joined with the concat demuxer of ffmpeg along with the audio
+typedef struct {
+    Segments_State state;
+    Render_Profile profile;
+    Render_Audio audio; // owns `audio.file_path`
+    Nob_Procs workers; // NOB_INVALID_PROC once they've exited
+    size_t finished;
+    Nob_Proc join;
+} Segments;
+
+// start the workers over the frames of `job` (its `profile` is `profile`);
+// with `job->last_frame` at RENDER_JOB_END, the track has `frame_count` of
+// them and the last worker renders the fade out of the music past them
+// NOTE: `audio` is the region of the track that goes along these frames
+bool segments_start(Segments *segments, const Render_Job *job,
+                    const Render_Profile *profile, size_t frame_count,
+                    Render_Audio audio);
+// reap the workers that have exited and join the parts once they're all done
+void segments_update(Segments *segments);
+// kill what is still running
+void segments_cancel(Segments *segments);
+void segments_free(Segments *segments);
+
+// `final.mp4` is rendered in `final.part000.mp4`, `final.part001.mp4`...
+// (a temporary string, see nob_temp_sprintf())
+const char *segment_part_path(const char *output, size_t i);
+// join the `count` parts of `profile->output` along with `audio` and remove
+// them, waiting for ffmpeg to be done
+bool segments_join(const Render_Profile *profile, size_t count,
+                   const Render_Audio *audio);
+
+#endif // SEGMENT_H_
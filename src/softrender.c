@@ -0,0 +1,457 @@
+#include "softrender.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#endif // _WIN32
+
+// NOTE: even so a band covers whole rows of the chroma planes
+#define SOFTRENDER_BAND_ROWS 16
+
+// the parameters of circle.fs in fft_render()
+#define SMEAR_RADIUS         0.3f
+#define SMEAR_POWER          3.0f
+#define CIRCLE_RADIUS        0.07f
+#define CIRCLE_POWER         5.0f
+
+typedef struct {
+    float x; // center of the cell
+    float smooth_y;
+    float smear_y;
+    float thick;
+    float smear_radius;
+    float circle_radius;
+    float color[3];
+    uint32_t pixel; // `color` as a RGBA pixel
+} Soft_Bin;
+
+typedef struct Soft_Renderer_Impl Soft_Renderer_Impl;
+
+typedef struct {
+    Soft_Renderer_Impl *renderer;
+    unsigned char *scratch; // one band of RGBA for the yuv420p output
+#ifndef _WIN32
+    pthread_t thread;
+#endif // _WIN32
+} Soft_Worker;
+
+struct Soft_Renderer_Impl {
+    size_t width;
+    size_t height;
+    bool yuv;
+    size_t band_count;
+
+    // the frame being drawn
+    Soft_Bin *bins;
+    size_t bin_count;
+    size_t bin_capacity;
+    uint32_t background;
+    unsigned char *out;
+
+    // NOTE: the caller is the last worker
+    Soft_Worker *workers;
+    size_t worker_count;
+#ifndef _WIN32
+    atomic_size_t next_band;
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    size_t generation; // bumped for each frame
+    size_t finished;   // threads done with the current frame
+    bool stop;
+#else
+    size_t next_band;
+#endif // _WIN32
+};
+
+static uint32_t pixel_from_color(Color c)
+{
+    unsigned char bytes[4] = {c.r, c.g, c.b, 255};
+    uint32_t pixel;
+    memcpy(&pixel, bytes, sizeof(pixel));
+    return pixel;
+}
+
+static void span_fill(uint32_t *span, size_t count, uint32_t pixel)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128i quad = _mm_set1_epi32((int)pixel);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128((__m128i *)(span + i), quad);
+#endif // __SSE2__
+    for (; i < count; ++i)
+        span[i] = pixel;
+}
+
+// the columns or rows whose pixel centers are in [a, b)
+static void pixel_range(float a, float b, long limit, long *first, long *last)
+{
+    *first = (long)ceilf(a - 0.5f);
+    *last = (long)ceilf(b - 0.5f);
+    if (*first < 0)
+        *first = 0;
+    if (*last > limit)
+        *last = limit;
+}
+
+// circle.fs at the texture coordinates (u, v), blended over `px` like raylib's
+// BLEND_ALPHA
+static inline void glow_pixel(unsigned char *px, float u, float v, float radius,
+                              float power, const float color[3])
+{
+    float du = u - 0.5f;
+    float dv = v - 0.5f;
+    float len = sqrtf(du * du + dv * dv);
+    if (len > 0.5f)
+        return;
+
+    float s = len - radius;
+    float k = 1.5f;
+    float alpha = 1.0f;
+    if (s > 0) {
+        float t = powf(1 - s / (0.5f - radius), power);
+        k = 1 + 0.5f * t;
+        alpha = fminf(1.5f * t, 1.0f);
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        float src = fminf(color[i] * k, 1.0f) * 255.0f;
+        px[i] = (unsigned char)(src * alpha + px[i] * (1 - alpha) + 0.5f);
+    }
+}
+
+// a quad of `circle.fs` over [x, x + w) x [y, y + h) with the texture
+// coordinates going from (0, v0) to (1, v1)
+static void glow_quad(unsigned char *band, size_t width, long band_y,
+                      long band_rows, float x, float y, float w, float h,
+                      float v0, float v1, float radius, float power,
+                      const float color[3])
+{
+    if (w <= 0 || h <= 0)
+        return;
+
+    long row, row_end;
+    pixel_range(y - band_y, y + h - band_y, band_rows, &row, &row_end);
+    for (; row < row_end; ++row) {
+        float v = v0 + (band_y + row + 0.5f - y) / h * (v1 - v0);
+        float dv = v - 0.5f;
+        if (dv * dv > 0.25f)
+            continue;
+
+        // only the span inside the disk
+        float du = sqrtf(0.25f - dv * dv);
+        long col, col_end;
+        pixel_range(x + (0.5f - du) * w, x + (0.5f + du) * w, width, &col,
+                    &col_end);
+        unsigned char *px = band + (row * width + col) * 4;
+        for (; col < col_end; ++col, px += 4) {
+            float u = (col + 0.5f - x) / w;
+            glow_pixel(px, u, v, radius, power, color);
+        }
+    }
+}
+
+static void draw_band(Soft_Renderer_Impl *r, size_t band_index,
+                      unsigned char *band)
+{
+    long width = r->width;
+    long band_y = band_index * SOFTRENDER_BAND_ROWS;
+    long band_rows = r->height - band_y;
+    if (band_rows > SOFTRENDER_BAND_ROWS)
+        band_rows = SOFTRENDER_BAND_ROWS;
+
+    span_fill((uint32_t *)band, width * band_rows, r->background);
+
+    // the bars
+    float bottom = r->height;
+    for (size_t i = 0; i < r->bin_count; ++i) {
+        const Soft_Bin *bin = &r->bins[i];
+        long col, col_end, row, row_end;
+        pixel_range(bin->x - bin->thick / 2, bin->x + bin->thick / 2, width,
+                    &col, &col_end);
+        pixel_range(bin->smooth_y - band_y, bottom - band_y, band_rows, &row,
+                    &row_end);
+        if (col >= col_end)
+            continue;
+        for (; row < row_end; ++row) {
+            uint32_t *span = (uint32_t *)band + row * width + col;
+            span_fill(span, col_end - col, bin->pixel);
+        }
+    }
+
+    // the smears, from the top half of the disk when going up and from the
+    // bottom half when going down
+    for (size_t i = 0; i < r->bin_count; ++i) {
+        const Soft_Bin *bin = &r->bins[i];
+        float radius = bin->smear_radius;
+        float x = bin->x - radius / 2;
+        if (bin->smooth_y >= bin->smear_y) {
+            glow_quad(band, width, band_y, band_rows, x, bin->smear_y, radius,
+                      bin->smooth_y - bin->smear_y, 0.0f, 0.5f, SMEAR_RADIUS,
+                      SMEAR_POWER, bin->color);
+        } else {
+            glow_quad(band, width, band_y, band_rows, x, bin->smooth_y, radius,
+                      bin->smear_y - bin->smooth_y, 0.5f, 1.0f, SMEAR_RADIUS,
+                      SMEAR_POWER, bin->color);
+        }
+    }
+
+    // the circles
+    for (size_t i = 0; i < r->bin_count; ++i) {
+        const Soft_Bin *bin = &r->bins[i];
+        float radius = bin->circle_radius;
+        glow_quad(band, width, band_y, band_rows, bin->x - radius,
+                  bin->smooth_y - radius, 2 * radius, 2 * radius, 0.0f, 1.0f,
+                  CIRCLE_RADIUS, CIRCLE_POWER, bin->color);
+    }
+}
+
+// the band in I420 with the coefficients of yuv420.fs
+static void band_to_yuv(Soft_Renderer_Impl *r, size_t band_index,
+                        const unsigned char *band)
+{
+    size_t width = r->width;
+    size_t height = r->height;
+    size_t band_y = band_index * SOFTRENDER_BAND_ROWS;
+    size_t band_rows = height - band_y;
+    if (band_rows > SOFTRENDER_BAND_ROWS)
+        band_rows = SOFTRENDER_BAND_ROWS;
+
+    unsigned char *luma = r->out + band_y * width;
+    for (size_t i = 0; i < band_rows * width; ++i) {
+        const unsigned char *px = band + i * 4;
+        float y = 16.0f + (65.481f * px[0] + 128.553f * px[1] +
+                           24.966f * px[2]) / 255.0f;
+        luma[i] = (unsigned char)(y + 0.5f);
+    }
+
+    size_t cw = width / 2;
+    unsigned char *u_plane = r->out + width * height;
+    unsigned char *v_plane = u_plane + cw * (height / 2);
+    for (size_t row = 0; row + 1 < band_rows; row += 2) {
+        unsigned char *u = u_plane + (band_y + row) / 2 * cw;
+        unsigned char *v = v_plane + (band_y + row) / 2 * cw;
+        const unsigned char *top = band + row * width * 4;
+        const unsigned char *below = top + width * 4;
+        for (size_t x = 0; x < cw; ++x) {
+            float c[3];
+            for (size_t k = 0; k < 3; ++k) {
+                c[k] = (top[x * 8 + k] + top[x * 8 + 4 + k] +
+                        below[x * 8 + k] + below[x * 8 + 4 + k]) /
+                       (4.0f * 255.0f);
+            }
+            u[x] = (unsigned char)(128.0f - 37.797f * c[0] - 74.203f * c[1] +
+                                   112.0f * c[2] + 0.5f);
+            v[x] = (unsigned char)(128.0f + 112.0f * c[0] - 93.786f * c[1] -
+                                   18.214f * c[2] + 0.5f);
+        }
+    }
+}
+
+static void draw_bands(Soft_Worker *w)
+{
+    Soft_Renderer_Impl *r = w->renderer;
+    for (;;) {
+#ifndef _WIN32
+        size_t band_index = atomic_fetch_add(&r->next_band, 1);
+#else
+        size_t band_index = r->next_band++;
+#endif // _WIN32
+        if (band_index >= r->band_count)
+            break;
+        if (r->yuv) {
+            draw_band(r, band_index, w->scratch);
+            band_to_yuv(r, band_index, w->scratch);
+        } else {
+            size_t offset = band_index * SOFTRENDER_BAND_ROWS * r->width * 4;
+            draw_band(r, band_index, r->out + offset);
+        }
+    }
+}
+
+#ifndef _WIN32
+static void *softrender_worker(void *arg)
+{
+    Soft_Worker *w = arg;
+    Soft_Renderer_Impl *r = w->renderer;
+
+    size_t generation = 0;
+    pthread_mutex_lock(&r->mutex);
+    for (;;) {
+        while (r->generation == generation && !r->stop)
+            pthread_cond_wait(&r->start, &r->mutex);
+        if (r->stop)
+            break;
+        generation = r->generation;
+        pthread_mutex_unlock(&r->mutex);
+
+        draw_bands(w);
+
+        pthread_mutex_lock(&r->mutex);
+        r->finished += 1;
+        pthread_cond_signal(&r->done);
+    }
+    pthread_mutex_unlock(&r->mutex);
+
+    return NULL;
+}
+#endif // _WIN32
+
+Soft_Renderer *softrender_start(size_t width, size_t height, bool yuv,
+                                size_t threads)
+{
+    assert(width > 0 && height > 0);
+    assert((!yuv || (width % 2 == 0 && height % 2 == 0)) &&
+           "yuv420p wants even dimensions");
+
+    Soft_Renderer_Impl *r = malloc(sizeof(*r));
+    assert(r != NULL && "Buy more RAM!!");
+    memset(r, 0, sizeof(*r));
+    r->width = width;
+    r->height = height;
+    r->yuv = yuv;
+    r->band_count = (height + SOFTRENDER_BAND_ROWS - 1) / SOFTRENDER_BAND_ROWS;
+
+#ifdef _WIN32
+    threads = 1;
+#else
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if (threads > r->band_count)
+        threads = r->band_count;
+#endif // _WIN32
+
+    r->worker_count = threads;
+    r->workers = malloc(threads * sizeof(*r->workers));
+    assert(r->workers != NULL && "Buy more RAM!!");
+    for (size_t i = 0; i < threads; ++i) {
+        r->workers[i].renderer = r;
+        r->workers[i].scratch = NULL;
+        if (yuv) {
+            r->workers[i].scratch = malloc(width * SOFTRENDER_BAND_ROWS * 4);
+            assert(r->workers[i].scratch != NULL && "Buy more RAM!!");
+        }
+    }
+
+#ifndef _WIN32
+    pthread_mutex_init(&r->mutex, NULL);
+    pthread_cond_init(&r->start, NULL);
+    pthread_cond_init(&r->done, NULL);
+    // NOTE: the last worker is the caller of softrender_frame()
+    for (size_t i = 0; i + 1 < threads; ++i) {
+        int err = pthread_create(&r->workers[i].thread, NULL,
+                                 softrender_worker, &r->workers[i]);
+        if (err != 0) {
+            TraceLog(LOG_WARNING,
+                     "SOFTRENDER: could only start %zu of %zu threads: %s", i,
+                     threads - 1, strerror(err));
+            // the caller takes the place of the thread that didn't start
+            for (size_t j = i + 1; j < threads; ++j)
+                free(r->workers[j].scratch);
+            r->worker_count = i + 1;
+            break;
+        }
+    }
+#endif // _WIN32
+
+    TraceLog(LOG_INFO, "SOFTRENDER: %zux%zu %s frames on %zu threads", width,
+             height, yuv ? "yuv420p" : "rgba", r->worker_count);
+    return r;
+}
+
+size_t softrender_frame_size(const Soft_Renderer *renderer)
+{
+    const Soft_Renderer_Impl *r = renderer;
+    if (r->yuv)
+        return r->width * r->height * 3 / 2;
+    return r->width * r->height * 4;
+}
+
+void softrender_frame(Soft_Renderer *renderer, const float *smooth,
+                      const float *smear, size_t m, Color background,
+                      void *out)
+{
+    Soft_Renderer_Impl *r = renderer;
+
+    // the geometry of fft_render() over the whole frame
+    if (m > r->bin_capacity) {
+        r->bins = realloc(r->bins, m * sizeof(*r->bins));
+        assert(r->bins != NULL && "Buy more RAM!!");
+        r->bin_capacity = m;
+    }
+    float width = r->width;
+    float height = r->height;
+    float cell_width = width / m;
+    for (size_t i = 0; i < m; ++i) {
+        Soft_Bin *bin = &r->bins[i];
+        float t = smooth[i];
+        Color color = ColorFromHSV((float)i / m * 360, 0.75f, 1.0f);
+        bin->x = i * cell_width + cell_width / 2;
+        bin->smooth_y = height - height * 2 / 3 * t;
+        bin->smear_y = height - height * 2 / 3 * smear[i];
+        bin->thick = cell_width / 3 * sqrtf(t);
+        bin->smear_radius = cell_width * 3 * sqrtf(t);
+        bin->circle_radius = cell_width * 6 * sqrtf(t);
+        bin->color[0] = color.r / 255.0f;
+        bin->color[1] = color.g / 255.0f;
+        bin->color[2] = color.b / 255.0f;
+        bin->pixel = pixel_from_color(color);
+    }
+    r->bin_count = m;
+    r->background = pixel_from_color(background);
+    r->out = out;
+
+#ifdef _WIN32
+    r->next_band = 0;
+    draw_bands(&r->workers[0]);
+#else
+    atomic_store(&r->next_band, 0);
+    pthread_mutex_lock(&r->mutex);
+    r->finished = 0;
+    r->generation += 1;
+    pthread_cond_broadcast(&r->start);
+    pthread_mutex_unlock(&r->mutex);
+
+    draw_bands(&r->workers[r->worker_count - 1]);
+
+    pthread_mutex_lock(&r->mutex);
+    while (r->finished + 1 < r->worker_count)
+        pthread_cond_wait(&r->done, &r->mutex);
+    pthread_mutex_unlock(&r->mutex);
+#endif // _WIN32
+}
+
+void softrender_stop(Soft_Renderer *renderer)
+{
+    Soft_Renderer_Impl *r = renderer;
+
+#ifndef _WIN32
+    pthread_mutex_lock(&r->mutex);
+    r->stop = true;
+    pthread_cond_broadcast(&r->start);
+    pthread_mutex_unlock(&r->mutex);
+    for (size_t i = 0; i + 1 < r->worker_count; ++i)
+        pthread_join(r->workers[i].thread, NULL);
+    pthread_cond_destroy(&r->done);
+    pthread_cond_destroy(&r->start);
+    pthread_mutex_destroy(&r->mutex);
+#endif // _WIN32
+
+    for (size_t i = 0; i < r->worker_count; ++i)
+        free(r->workers[i].scratch);
+    free(r->workers);
+    free(r->bins);
+    free(r);
+}
@@ -0,0 +1,25 @@
+#ifndef SOFTRENDER_H_
+#define SOFTRENDER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+typedef void Soft_Renderer;
+
+// NOTE: draws what fft_render() draws (the bars, the smears and the glowing
+//       circles of circle.fs) on the CPU without any GL context; the frame is
+//       split into bands of rows drawn by `threads` threads (0 means one per
+//       CPU) and comes out top row first, either in RGBA or in yuv420p
+Soft_Renderer *softrender_start(size_t width, size_t height, bool yuv,
+                                size_t threads);
+// the size of a frame in bytes
+size_t softrender_frame_size(const Soft_Renderer *renderer);
+// draw the `m` bins of `smooth` & `smear` into `out`
+void softrender_frame(Soft_Renderer *renderer, const float *smooth,
+                      const float *smear, size_t m, Color background,
+                      void *out);
+void softrender_stop(Soft_Renderer *renderer);
+
+#endif // SOFTRENDER_H_
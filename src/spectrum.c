@@ -0,0 +1,226 @@
+#include "spectrum.h"
+#include "pcm.h"
+#include "raylib.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPECTRUM_MAGIC      "MZSP"
+#define SPECTRUM_VERSION    1
+// the bytes hashed at both ends of the track, along with its size
+#define SPECTRUM_HASH_BYTES (64 * 1024)
+
+// NOTE: the values are stored in the byte order of the machine; a sidecar
+//       from another one doesn't match and is made again
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    uint32_t n;
+    uint32_t fps;
+    float band_step;
+    uint32_t hop;
+    uint32_t sample_rate;
+    uint32_t bins;
+    uint64_t source_frames;
+    uint64_t frame_count;
+    uint8_t reserved[16];
+} Spectrum_Header;
+
+typedef struct {
+    FILE *f;
+    char *path;
+    Spectrum_Header header;
+    uint16_t *frame; // the quantized bands of a frame
+    bool failed;
+} Spectrum_File;
+
+static const char *spectrum_path(const char *track_path, size_t fps)
+{
+    return TextFormat("%s.%zufps.spectrum", track_path, fps);
+}
+
+// FNV-1a of the size and both ends of the file: cheap even for a long track
+// and enough to tell that it was replaced
+static bool spectrum_source_hash(const char *track_path, uint64_t *hash)
+{
+    size_t size = 0;
+    const unsigned char *data = pcm_map_file(track_path, &size);
+    if (data == NULL)
+        return false;
+
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(size); ++i)
+        h = (h ^ ((size >> (i * 8)) & 0xFF)) * 1099511628211ULL;
+    size_t head = size < SPECTRUM_HASH_BYTES ? size : SPECTRUM_HASH_BYTES;
+    for (size_t i = 0; i < head; ++i)
+        h = (h ^ data[i]) * 1099511628211ULL;
+    size_t tail = size - head < SPECTRUM_HASH_BYTES ? size - head
+                                                     : SPECTRUM_HASH_BYTES;
+    for (size_t i = size - tail; i < size; ++i)
+        h = (h ^ data[i]) * 1099511628211ULL;
+
+    pcm_unmap_file((void *)data, size);
+    *hash = h;
+    return true;
+}
+
+bool spectrum_open(const char *track_path, const Spectrum_Info *expected,
+                   Spectrum *spectrum)
+{
+    memset(spectrum, 0, sizeof(*spectrum));
+    const char *path = spectrum_path(track_path, expected->fps);
+    if (!FileExists(path))
+        return false;
+
+    size_t size = 0;
+    void *map = pcm_map_file(path, &size);
+    if (map == NULL)
+        return false;
+
+    const Spectrum_Header *h = map;
+    uint64_t hash = 0;
+    bool ok = size >= sizeof(*h) &&
+              memcmp(h->magic, SPECTRUM_MAGIC, sizeof(h->magic)) == 0 &&
+              h->version == SPECTRUM_VERSION && h->n == expected->n &&
+              h->fps == expected->fps &&
+              h->band_step == expected->band_step && h->bins > 0 &&
+              h->bins <= h->n / 2 &&
+              (size - sizeof(*h)) / sizeof(uint16_t) / h->bins >=
+                  h->frame_count &&
+              spectrum_source_hash(track_path, &hash) &&
+              h->source_hash == hash;
+    if (!ok) {
+        TraceLog(LOG_WARNING, "SPECTRUM: %s is out of date", path);
+        pcm_unmap_file(map, size);
+        return false;
+    }
+
+    spectrum->info = (Spectrum_Info){
+        .n = h->n,
+        .fps = h->fps,
+        .band_step = h->band_step,
+        .hop = h->hop,
+        .sample_rate = h->sample_rate,
+        .source_frames = h->source_frames,
+        .bins = h->bins,
+        .frame_count = h->frame_count,
+    };
+    spectrum->map = map;
+    spectrum->map_size = size;
+    spectrum->frames = (const uint16_t *)(h + 1);
+    return true;
+}
+
+void spectrum_close(Spectrum *spectrum)
+{
+    if (spectrum->map != NULL)
+        pcm_unmap_file(spectrum->map, spectrum->map_size);
+    memset(spectrum, 0, sizeof(*spectrum));
+}
+
+void spectrum_read(const Spectrum *spectrum, size_t frame, float *out)
+{
+    size_t bins = spectrum->info.bins;
+    if (frame >= spectrum->info.frame_count) {
+        memset(out, 0, bins * sizeof(*out));
+        return;
+    }
+    const uint16_t *bands = spectrum->frames + frame * bins;
+    for (size_t i = 0; i < bins; ++i)
+        out[i] = bands[i] / 65535.0f;
+}
+
+Spectrum_Writer *spectrum_write_start(const char *track_path,
+                                      const Spectrum_Info *info)
+{
+    Spectrum_File *w = malloc(sizeof(*w));
+    assert(w != NULL && "Buy more RAM!!");
+    memset(w, 0, sizeof(*w));
+    w->header = (Spectrum_Header){
+        .magic = SPECTRUM_MAGIC,
+        .version = SPECTRUM_VERSION,
+        .n = info->n,
+        .fps = info->fps,
+        .band_step = info->band_step,
+        .hop = info->hop,
+        .sample_rate = info->sample_rate,
+        .source_frames = info->source_frames,
+    };
+    if (!spectrum_source_hash(track_path, &w->header.source_hash)) {
+        free(w);
+        return NULL;
+    }
+
+    w->path = strdup(spectrum_path(track_path, info->fps));
+    assert(w->path != NULL && "Buy more RAM!!");
+    const char *temp_path = TextFormat("%s.tmp", w->path);
+    w->f = fopen(temp_path, "wb");
+    if (w->f == NULL) {
+        TraceLog(LOG_ERROR, "SPECTRUM: could not open %s: %s", temp_path,
+                 strerror(errno));
+        free(w->path);
+        free(w);
+        return NULL;
+    }
+    // the header is written again once the counts are known
+    if (fwrite(&w->header, sizeof(w->header), 1, w->f) != 1)
+        w->failed = true;
+    return w;
+}
+
+void spectrum_write_frame(Spectrum_Writer *writer, const float *bands,
+                          size_t bins)
+{
+    Spectrum_File *w = writer;
+    if (w->header.bins == 0) {
+        w->header.bins = bins;
+        w->frame = malloc(bins * sizeof(*w->frame));
+        assert(w->frame != NULL && "Buy more RAM!!");
+    }
+    assert(bins == w->header.bins);
+
+    for (size_t i = 0; i < bins; ++i) {
+        float b = bands[i];
+        b = b < 0.0f ? 0.0f : b > 1.0f ? 1.0f : b;
+        w->frame[i] = (uint16_t)(b * 65535.0f + 0.5f);
+    }
+    if (fwrite(w->frame, sizeof(*w->frame), bins, w->f) != bins)
+        w->failed = true;
+    w->header.frame_count += 1;
+}
+
+bool spectrum_write_end(Spectrum_Writer *writer)
+{
+    Spectrum_File *w = writer;
+    if (fseek(w->f, 0, SEEK_SET) != 0 ||
+        fwrite(&w->header, sizeof(w->header), 1, w->f) != 1)
+        w->failed = true;
+    if (fclose(w->f) != 0)
+        w->failed = true;
+
+    const char *temp_path = TextFormat("%s.tmp", w->path);
+    bool ok = !w->failed && w->header.bins > 0;
+    if (!ok) {
+        TraceLog(LOG_ERROR, "SPECTRUM: could not write %s", temp_path);
+        remove(temp_path);
+    } else {
+#ifdef _WIN32
+        // NOTE: rename() doesn't replace an existing file on Windows
+        remove(w->path);
+#endif // _WIN32
+        if (rename(temp_path, w->path) != 0) {
+            TraceLog(LOG_ERROR, "SPECTRUM: could not rename %s to %s: %s",
+                     temp_path, w->path, strerror(errno));
+            remove(temp_path);
+            ok = false;
+        }
+    }
+
+    free(w->frame);
+    free(w->path);
+    free(w);
+    return ok;
+}
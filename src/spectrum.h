@@ -0,0 +1,50 @@
+#ifndef SPECTRUM_H_
+#define SPECTRUM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// NOTE: the analysis of a whole track (the log bands of the FFT of every
+//       video frame, before any smoothing) saved next to it as a sidecar:
+//       `music/intro.flac` gets `music/intro.flac.30fps.spectrum`; a render
+//       that finds a sidecar made from the same file by the same analysis
+//       maps it and neither decodes the track nor runs the FFT
+typedef struct {
+    size_t n;         // samples of the FFT window
+    size_t fps;       // frames per second of the video
+    float band_step;  // the ratio between the frequencies of two bands
+    size_t hop;       // samples between two frames, give or take one
+    size_t sample_rate;
+    size_t source_frames; // samples (per channel) of the track
+    size_t bins;          // bands per frame
+    size_t frame_count;   // up to the silence after the end of the track
+} Spectrum_Info;
+
+typedef struct {
+    Spectrum_Info info;
+    void *map; // NULL: not opened
+    size_t map_size;
+    const uint16_t *frames; // `bins` bands in 0..65535 per frame
+} Spectrum;
+
+// map the sidecar of `track_path` if it was made from this very file by the
+// analysis `expected` describes (`n`, `fps` & `band_step`)
+bool spectrum_open(const char *track_path, const Spectrum_Info *expected,
+                   Spectrum *spectrum);
+void spectrum_close(Spectrum *spectrum);
+// the bands of `frame` in 0..1 into `out` (zeros past the end)
+void spectrum_read(const Spectrum *spectrum, size_t frame, float *out);
+
+typedef void Spectrum_Writer;
+
+// the sidecar is written into a temporary file and renamed once complete;
+// `info` has everything but `bins` & `frame_count`, which come with the frames
+Spectrum_Writer *spectrum_write_start(const char *track_path,
+                                      const Spectrum_Info *info);
+// `bins` bands in 0..1, the same count for every frame
+void spectrum_write_frame(Spectrum_Writer *writer, const float *bands,
+                          size_t bins);
+bool spectrum_write_end(Spectrum_Writer *writer);
+
+#endif // SPECTRUM_H_
@@ -0,0 +1,253 @@
+#include "y4m.h"
+#include "raylib.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define _WINUSER_
+#define _WINGDI_
+#define _IMM_
+#define _WINCON_
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#define Y4M_FRAME_HEADER     "FRAME\n"
+#define Y4M_FRAME_HEADER_LEN (sizeof(Y4M_FRAME_HEADER) - 1)
+#define Y4M_HEADER_CAP       128
+
+typedef struct {
+    char *file_path;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif // _WIN32
+    unsigned char *map;
+    size_t capacity; // bytes of the file that are mapped
+    size_t size;     // bytes written
+    size_t frame_size;
+    unsigned char *last; // the last frame written, NULL before the first one
+} Y4M_File;
+
+static void y4m_unmap(Y4M_File *f)
+{
+    if (f->map == NULL)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(f->map);
+    CloseHandle(f->mapping);
+    f->mapping = NULL;
+#else
+    munmap(f->map, f->capacity);
+#endif // _WIN32
+    f->map = NULL;
+}
+
+#ifdef __APPLE__
+// posix_fallocate() for macOS, where ftruncate() only makes a sparse file:
+// the blocks past the end of the file are reserved first
+static int y4m_fallocate(int fd, size_t size)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+        return errno;
+    if ((off_t)size > st.st_size) {
+        fstore_t store = {
+            .fst_flags = F_ALLOCATECONTIG,
+            .fst_posmode = F_PEOFPOSMODE,
+            .fst_offset = 0,
+            .fst_length = (off_t)size - st.st_size,
+        };
+        if (fcntl(fd, F_PREALLOCATE, &store) < 0) {
+            // NOTE: the disk may be too fragmented for a contiguous run
+            store.fst_flags = F_ALLOCATEALL;
+            if (fcntl(fd, F_PREALLOCATE, &store) < 0)
+                return errno;
+        }
+    }
+    return ftruncate(fd, size) == 0 ? 0 : errno;
+}
+#endif // __APPLE__
+
+// (re)map the file at `capacity` bytes, which are allocated on the disk
+// beforehand so a full disk is an error here and not a crash when the frames
+// are written into the mapping
+static bool y4m_map(Y4M_File *f, size_t capacity)
+{
+    size_t last = f->last != NULL ? (size_t)(f->last - f->map) : 0;
+    y4m_unmap(f);
+#ifdef _WIN32
+    // NOTE: the mapping extends the file
+    f->mapping =
+        CreateFileMappingA(f->file, NULL, PAGE_READWRITE,
+                           (DWORD)((unsigned long long)capacity >> 32),
+                           (DWORD)(capacity & 0xFFFFFFFF), NULL);
+    if (f->mapping == NULL) {
+        TraceLog(LOG_ERROR, "Y4M: could not map %s. System Error Code: %d",
+                 f->file_path, GetLastError());
+        return false;
+    }
+    f->map = MapViewOfFile(f->mapping, FILE_MAP_WRITE, 0, 0, capacity);
+    if (f->map == NULL) {
+        TraceLog(LOG_ERROR, "Y4M: could not map %s. System Error Code: %d",
+                 f->file_path, GetLastError());
+        CloseHandle(f->mapping);
+        f->mapping = NULL;
+        return false;
+    }
+#else
+#ifdef __APPLE__
+    int err = y4m_fallocate(f->fd, capacity);
+#else
+    int err = posix_fallocate(f->fd, 0, capacity);
+#endif // __APPLE__
+    if (err != 0) {
+        TraceLog(LOG_ERROR, "Y4M: could not allocate %zu bytes for %s: %s",
+                 capacity, f->file_path, strerror(err));
+        return false;
+    }
+    void *map =
+        mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, f->fd, 0);
+    if (map == MAP_FAILED) {
+        TraceLog(LOG_ERROR, "Y4M: could not map %s: %s", f->file_path,
+                 strerror(errno));
+        return false;
+    }
+    f->map = map;
+    // the frames are written once from start to finish
+    madvise(f->map, capacity, MADV_SEQUENTIAL);
+#endif // _WIN32
+    f->capacity = capacity;
+    if (f->last != NULL)
+        f->last = f->map + last;
+    return true;
+}
+
+Y4M_Writer *y4m_start(const char *file_path, size_t width, size_t height,
+                      size_t fps, size_t frame_estimate)
+{
+    assert(width % 2 == 0 && height % 2 == 0);
+
+    Y4M_File *f = malloc(sizeof(*f));
+    assert(f != NULL && "Buy more RAM!!");
+    memset(f, 0, sizeof(*f));
+    f->file_path = strdup(file_path);
+    assert(f->file_path != NULL && "Buy more RAM!!");
+    f->frame_size = width * height * 3 / 2;
+
+#ifdef _WIN32
+    f->file = CreateFileA(file_path, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                          CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f->file == INVALID_HANDLE_VALUE) {
+        TraceLog(LOG_ERROR, "Y4M: could not open %s. System Error Code: %d",
+                 file_path, GetLastError());
+        free(f->file_path);
+        free(f);
+        return NULL;
+    }
+#else
+    f->fd = open(file_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (f->fd < 0) {
+        TraceLog(LOG_ERROR, "Y4M: could not open %s: %s", file_path,
+                 strerror(errno));
+        free(f->file_path);
+        free(f);
+        return NULL;
+    }
+#endif // _WIN32
+
+    // NOTE: the frames are the limited range BT.601 ones of yuv420.fs and
+    //       softrender.c
+    char header[Y4M_HEADER_CAP];
+    int n = snprintf(header, sizeof(header),
+                     "YUV4MPEG2 W%zu H%zu F%zu:1 Ip A1:1 C420jpeg "
+                     "XCOLORRANGE=LIMITED\n",
+                     width, height, fps);
+    assert(n > 0 && (size_t)n < sizeof(header));
+
+    if (frame_estimate == 0)
+        frame_estimate = 1;
+    size_t capacity =
+        n + frame_estimate * (Y4M_FRAME_HEADER_LEN + f->frame_size);
+    if (!y4m_map(f, capacity)) {
+        y4m_end(f);
+        return NULL;
+    }
+    memcpy(f->map, header, n);
+    f->size = n;
+    return f;
+}
+
+void *y4m_frame(Y4M_Writer *y4m)
+{
+    Y4M_File *f = y4m;
+    if (f->map == NULL)
+        return NULL;
+    size_t needed = Y4M_FRAME_HEADER_LEN + f->frame_size;
+    if (f->size + needed > f->capacity) {
+        // NOTE: the estimate was short, by the fade out most of the time
+        size_t capacity = f->capacity + f->capacity / 2;
+        if (capacity < f->size + needed)
+            capacity = f->size + needed;
+        if (!y4m_map(f, capacity))
+            return NULL;
+    }
+
+    memcpy(f->map + f->size, Y4M_FRAME_HEADER, Y4M_FRAME_HEADER_LEN);
+    f->last = f->map + f->size + Y4M_FRAME_HEADER_LEN;
+    f->size += needed;
+    return f->last;
+}
+
+bool y4m_repeat(Y4M_Writer *y4m)
+{
+    Y4M_File *f = y4m;
+    assert(f->last != NULL);
+    if (f->map == NULL)
+        return false;
+    size_t last = f->last - f->map;
+    unsigned char *frame = y4m_frame(f);
+    if (frame == NULL)
+        return false;
+    // the mapping may have moved
+    memcpy(frame, f->map + last, f->frame_size);
+    return true;
+}
+
+bool y4m_end(Y4M_Writer *y4m)
+{
+    Y4M_File *f = y4m;
+    bool ok = f->map != NULL;
+    y4m_unmap(f);
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    size.QuadPart = f->size;
+    if (!SetFilePointerEx(f->file, size, NULL, FILE_BEGIN) ||
+        !SetEndOfFile(f->file)) {
+        TraceLog(LOG_ERROR, "Y4M: could not truncate %s. System Error Code: %d",
+                 f->file_path, GetLastError());
+        ok = false;
+    }
+    CloseHandle(f->file);
+#else
+    if (ftruncate(f->fd, f->size) < 0) {
+        TraceLog(LOG_ERROR, "Y4M: could not truncate %s: %s", f->file_path,
+                 strerror(errno));
+        ok = false;
+    }
+    close(f->fd);
+#endif // _WIN32
+    free(f->file_path);
+    free(f);
+    return ok;
+}
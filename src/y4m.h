@@ -0,0 +1,24 @@
+#ifndef Y4M_H_
+#define Y4M_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef void Y4M_Writer;
+
+// NOTE: a sink for the frames that doesn't encode them: they're written as
+//       is (yuv420p) into a YUV4MPEG2 file to be encoded later by a separate
+//       ffmpeg; the file is preallocated for `frame_estimate` frames and
+//       mapped in memory so a frame costs a copy and no system call (the
+//       mapping grows when the estimate was too short)
+Y4M_Writer *y4m_start(const char *file_path, size_t width, size_t height,
+                      size_t fps, size_t frame_estimate);
+// where the next frame goes, right in the mapping; NULL if the file could
+// not grow
+void *y4m_frame(Y4M_Writer *y4m);
+// write the last frame once more
+bool y4m_repeat(Y4M_Writer *y4m);
+// cut the file down to the frames written and close it
+bool y4m_end(Y4M_Writer *y4m);
+
+#endif // Y4M_H_